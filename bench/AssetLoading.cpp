@@ -0,0 +1,89 @@
+#include <assetloader.hpp>
+
+#include "benchutils.hpp"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/*! @brief Compares reading many files one after another against the asset loader with several I/O threads.
+ *
+ * The files are written by the bench and usually still in the page cache, run with dropped caches to
+ * measure the disk.
+ *
+ * Usage: bench_AssetLoading [fileCount] [fileSize]
+ */
+
+int main(int argc, char** argv)
+{
+    uint32_t fileCount = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 256;
+    size_t fileSize = argc > 2 ? static_cast<size_t>(atoi(argv[2])) : 256 * 1024;
+    double bytes = static_cast<double>(fileCount) * static_cast<double>(fileSize);
+
+    std::string dir = "bench_assets";
+    mkdir(dir.c_str(), 0755);
+
+    std::vector<char> data(fileSize);
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        data[i] = static_cast<char>(i);
+    }
+
+    std::vector<std::string> paths(fileCount);
+    for (uint32_t i = 0; i < fileCount; i++)
+    {
+        paths[i] = dir + "/asset" + std::to_string(i) + ".bin";
+
+        std::ofstream file(dir + "/asset" + std::to_string(i) + ".bin", std::ios::binary | std::ios::trunc);
+        file.write(data.data(), data.size());
+    }
+
+    //synchronous reads on the calling thread, as the render loop did before, results are kept like loaded assets
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::vector<std::vector<char>> assets;
+        for (const auto& path : paths)
+        {
+            assets.push_back(AssetLoader::readAsset(path));
+        }
+    }
+    report("synchronous (1 threads)", fileCount, "files", bytes, secondsSince(start));
+
+    uint32_t threadCounts[] = {1, 2, 4, 8};
+    for (uint32_t threadCount : threadCounts)
+    {
+        AssetLoader loader;
+        loader.create(threadCount);
+
+        start = std::chrono::steady_clock::now();
+
+        std::vector<AssetHandle<std::vector<char>>> handles;
+        for (const auto& path : paths)
+        {
+            handles.push_back(loader.load(path));
+        }
+        for (auto& handle : handles)
+        {
+            handle.get();
+        }
+
+        report("asset loader (" + std::to_string(threadCount) + " threads)", fileCount, "files", bytes, secondsSince(start));
+
+        loader.destroy();
+    }
+
+    for (uint32_t i = 0; i < fileCount; i++)
+    {
+        remove((dir + "/asset" + std::to_string(i) + ".bin").c_str());
+    }
+    rmdir(dir.c_str());
+
+    return 0;
+}
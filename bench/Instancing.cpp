@@ -0,0 +1,93 @@
+#include <window.hpp>
+#include <utils.hpp>
+
+#include "benchutils.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+/*! @brief Compares drawing a grid of quads with one instanced draw, one indirect draw list and one draw call per quad.
+ *
+ * Usage: bench_Instancing [quadCount] [frameCount]
+ */
+
+std::vector<InstanceData> createGrid(uint32_t quadCount)
+{
+    uint32_t side = 1;
+    while (side * side < quadCount)
+    {
+        side++;
+    }
+
+    float cell = 2.0f / side;
+
+    std::vector<InstanceData> instances(quadCount);
+    for (uint32_t i = 0; i < quadCount; i++)
+    {
+        float x = -1.0f + cell * (i % side + 0.5f);
+        float y = -1.0f + cell * (i / side + 0.5f);
+
+        instances[i].transform = glm::vec4(x, y, cell * 0.8f, cell * 0.8f);
+        instances[i].color = glm::vec3(static_cast<float>(i % side) / side, static_cast<float>(i / side) / side, 1.0f);
+    }
+    return instances;
+}
+
+void run(const char* name, DrawMode drawMode, const std::vector<InstanceData>& instances, uint32_t frameCount)
+{
+    DeviceRegistry deviceRegistry;
+    deviceRegistry.create();
+
+    AssetLoader assetLoader;
+    assetLoader.create(1);
+
+    Window window;
+    window.setHeadless(true);
+    window.setSize(1024, 1024);
+    window.setInstances(instances);
+    window.setDrawMode(drawMode);
+    window.launch(deviceRegistry, assetLoader);
+
+    //first frames include pipeline creation and uploads
+    window.drawFrame();
+    window.drawFrame();
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < frameCount; i++)
+    {
+        window.drawFrame();
+    }
+    double seconds = secondsSince(start);
+
+    ScopeStats stats = window.getProfiler()->getStats("main pass");
+
+    window.destroy();
+
+    std::cout << name << ": " << seconds * 1000.0 / frameCount << " ms/frame cpu, "
+        << stats.avg << " ms/frame gpu (p99 " << stats.p99 << " ms), "
+        << instances.size() * frameCount / seconds << " quads/s" << std::endl;
+
+    assetLoader.destroy();
+    deviceRegistry.destroy();
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t quadCount = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 100000;
+    uint32_t frameCount = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 64;
+
+    createInstance(true);
+
+    std::vector<InstanceData> instances = createGrid(quadCount);
+
+    run("instanced", DRAW_MODE_INSTANCED, instances, frameCount);
+    run("indirect", DRAW_MODE_INDIRECT, instances, frameCount);
+    run("per-quad", DRAW_MODE_DIRECT, instances, frameCount);
+
+    destroyInstance();
+
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include <meshfile.hpp>
+
+#include "benchutils.hpp"
+
+#include <string.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+/*! @brief Compares loading a mesh by parsing OBJ text against mapping a binary mesh file.
+ *
+ * Both paths end with the vertex and index streams copied into a preallocated buffer standing in for the
+ * staging ring, which is where Window::createGeometryBuffers copies them. The OBJ path also packs vertices
+ * and narrows indices, the work the mesh file has done ahead of time.
+ *
+ * Usage: bench_MeshLoad [gridSize] [iterations]
+ */
+
+void writeGridObj(const std::string& path, uint32_t gridSize)
+{
+    std::ofstream file(path, std::ios::trunc);
+
+    for (uint32_t y = 0; y <= gridSize; y++)
+    {
+        for (uint32_t x = 0; x <= gridSize; x++)
+        {
+            float u = static_cast<float>(x) / gridSize;
+            float v = static_cast<float>(y) / gridSize;
+            file << "v " << u * 2.0f - 1.0f << " " << v * 2.0f - 1.0f << " 0 " << u << " " << v << " 1\n";
+        }
+    }
+
+    for (uint32_t y = 0; y < gridSize; y++)
+    {
+        for (uint32_t x = 0; x < gridSize; x++)
+        {
+            uint32_t i = y * (gridSize + 1) + x + 1;
+            file << "f " << i << " " << i + 1 << " " << i + gridSize + 2 << " " << i + gridSize + 1 << "\n";
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t gridSize = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 512;
+    uint32_t iterations = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 8;
+
+    std::string objPath = "bench_mesh.obj";
+    std::string meshPath = "bench_mesh.hmesh";
+
+    writeGridObj(objPath, gridSize);
+
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    loadObjFile(objPath, vertices, indices);
+    writeMeshFile(meshPath, vertices, indices, VERTEX_FORMAT_FLOAT);
+
+    std::vector<uint8_t> staging(vertices.size() * sizeof(Vertex) + indices.size() * sizeof(uint32_t));
+
+    //first iterations also fault the files into the page cache, both paths are timed warm
+    double parseSeconds = 0.0;
+    double mapSeconds = 0.0;
+    for (uint32_t i = 0; i < iterations + 1; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        {
+            std::vector<Vertex> parsedVertices;
+            std::vector<uint32_t> parsedIndices;
+            loadObjFile(objPath, parsedVertices, parsedIndices);
+
+            std::vector<uint8_t> packedVertices = packVertices(parsedVertices, VERTEX_FORMAT_FLOAT);
+            memcpy(staging.data(), packedVertices.data(), packedVertices.size());
+
+            uint8_t* pIndices = staging.data() + packedVertices.size();
+            for (size_t j = 0; j < parsedIndices.size(); j++)
+            {
+                if (parsedVertices.size() <= 65536)
+                {
+                    uint16_t index = static_cast<uint16_t>(parsedIndices[j]);
+                    memcpy(pIndices + j * 2, &index, sizeof(index));
+                }
+                else
+                {
+                    memcpy(pIndices + j * 4, &parsedIndices[j], sizeof(uint32_t));
+                }
+            }
+        }
+        double parse = secondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        {
+            MeshFile meshFile;
+            meshFile.create(meshPath);
+
+            memcpy(staging.data(), meshFile.getVertexData(), (size_t) meshFile.getVertexDataSize());
+            memcpy(staging.data() + meshFile.getVertexDataSize(), meshFile.getIndexData(), (size_t) meshFile.getIndexDataSize());
+
+            meshFile.destroy();
+        }
+        double map = secondsSince(start);
+
+        if (i > 0)
+        {
+            parseSeconds += parse;
+            mapSeconds += map;
+        }
+    }
+
+    std::cout << vertices.size() << " vertices, " << indices.size() / 3 << " triangles" << std::endl;
+    std::cout << "obj parse: " << parseSeconds * 1000.0 / iterations << " ms/load" << std::endl;
+    std::cout << "mesh file: " << mapSeconds * 1000.0 / iterations << " ms/load" << std::endl;
+
+    remove(objPath.c_str());
+    remove(meshPath.c_str());
+
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include <device.hpp>
+#include <utils.hpp>
+
+#include "benchutils.hpp"
+
+#include <string.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+/*! @brief Compares per-copy uploads through Device::copyBuffer against a single TransferBatch submission.
+ *
+ * Usage: bench_Transfer [copyCount] [copySize]
+ */
+
+int main(int argc, char** argv)
+{
+    uint32_t copyCount = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 1024;
+    VkDeviceSize copySize = argc > 2 ? static_cast<VkDeviceSize>(atoi(argv[2])) : 4096;
+    double bytes = static_cast<double>(copyCount) * static_cast<double>(copySize);
+
+    createInstance(true);
+
+    //headless device, no surface or display needed
+    VkSurfaceKHR surface = VK_NULL_HANDLE;
+
+    Device device;
+    device.create(surface);
+
+    std::vector<char> data(static_cast<size_t>(copySize));
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        data[i] = static_cast<char>(i);
+    }
+
+    std::vector<VkBuffer> buffers(copyCount);
+    std::vector<Allocation> allocations(copyCount);
+    for (uint32_t i = 0; i < copyCount; i++)
+    {
+        device.createBuffer(copySize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffers[i], allocations[i]);
+    }
+
+    Queue queue = device.getGraphicsQueues()[0];
+    VkCommandPool pool = device.getCommandPool(queue);
+
+    //per-copy path: one staging buffer, command buffer and queue idle per copy
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < copyCount; i++)
+    {
+        VkBuffer stagingBuffer;
+        Allocation stagingAllocation;
+        device.createBuffer(copySize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingAllocation);
+
+        memcpy(stagingAllocation.pMapped, data.data(), (size_t) copySize);
+        device.copyBuffer(stagingBuffer, buffers[i], copySize, pool, queue.queue);
+
+        device.destroyBuffer(stagingBuffer, stagingAllocation);
+    }
+    report("per-copy", copyCount, "copies", bytes, secondsSince(start));
+
+    //batched path: staged through the ring and submitted as one command buffer with one fence
+    start = std::chrono::steady_clock::now();
+    TransferBatch batch;
+    for (uint32_t i = 0; i < copyCount; i++)
+    {
+        device.stageBuffer(batch, buffers[i], 0, data.data(), copySize);
+    }
+    UploadToken token = device.submitTransfers(batch);
+    device.waitForUpload(token);
+    report("batched", copyCount, "copies", bytes, secondsSince(start));
+
+    device.waitIdle();
+
+    for (uint32_t i = 0; i < copyCount; i++)
+    {
+        device.destroyBuffer(buffers[i], allocations[i]);
+    }
+
+    device.destroy();
+
+    destroyInstance();
+
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include <vertexformat.hpp>
+
+#include "benchutils.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+/*! @brief Compares memory footprint and CPU encoding cost of the packed vertex formats.
+ *
+ * Fetch bandwidth scales with the vertex stride, so the size ratio is also the bandwidth ratio for a mesh
+ * whose vertices are each fetched once.
+ *
+ * Usage: bench_VertexFormats [vertexCount]
+ */
+
+int main(int argc, char** argv)
+{
+    uint32_t vertexCount = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 1000000;
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+    std::vector<Vertex> vertices(vertexCount);
+    for (auto& vertex : vertices)
+    {
+        vertex.pos = glm::vec2(distribution(random), distribution(random));
+        vertex.color = glm::vec3(distribution(random) * 0.5f + 0.5f, distribution(random) * 0.5f + 0.5f, distribution(random) * 0.5f + 0.5f);
+    }
+
+    const char* names[] = {"float", "half", "snorm16"};
+    VertexFormat formats[] = {VERTEX_FORMAT_FLOAT, VERTEX_FORMAT_HALF, VERTEX_FORMAT_SNORM16};
+
+    double floatBytes = static_cast<double>(vertexCount) * getVertexStride(VERTEX_FORMAT_FLOAT);
+
+    for (int i = 0; i < 3; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<uint8_t> packed = packVertices(vertices, formats[i]);
+        double seconds = secondsSince(start);
+
+        std::cout << names[i] << ": " << getVertexStride(formats[i]) << " bytes/vertex, "
+            << packed.size() / (1024.0 * 1024.0) << " MB, "
+            << packed.size() / floatBytes * 100.0 << "% of float, packed in "
+            << seconds * 1000.0 << " ms" << std::endl;
+    }
+
+    //scalar against bulk conversion of the same position stream
+    std::vector<float> positions(vertexCount * 2);
+    for (auto& position : positions)
+    {
+        position = distribution(random);
+    }
+
+    std::vector<uint16_t> halves(positions.size());
+    std::vector<int16_t> snorms(positions.size());
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < positions.size(); i++)
+    {
+        halves[i] = encodeHalf(positions[i]);
+    }
+    double scalarHalf = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    encodeHalf(positions.data(), halves.data(), positions.size());
+    double bulkHalf = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < positions.size(); i++)
+    {
+        snorms[i] = encodeSnorm16(positions[i]);
+    }
+    double scalarSnorm = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    encodeSnorm16(positions.data(), snorms.data(), positions.size());
+    double bulkSnorm = secondsSince(start);
+
+    std::cout << "half: scalar " << scalarHalf * 1000.0 << " ms, bulk " << bulkHalf * 1000.0 << " ms" << std::endl;
+    std::cout << "snorm16: scalar " << scalarSnorm * 1000.0 << " ms, bulk " << bulkSnorm * 1000.0 << " ms" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+/*! @brief Returns the seconds passed since 'start'.
+ *
+ */
+inline double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/*! @brief Prints the duration of a measured run with its rate of 'unit' and its throughput.
+ *
+ * @param[in] count Number of items processed, e.g. copies or files
+ * @param[in] bytes Number of bytes processed
+ */
+inline void report(const std::string& name, uint64_t count, const char* unit, double bytes, double seconds)
+{
+    std::cout << name << ": " << seconds * 1000.0 << " ms, "
+        << count / seconds << " " << unit << "/s, "
+        << bytes / seconds / (1024.0 * 1024.0) << " MB/s" << std::endl;
+}
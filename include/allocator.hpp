@@ -0,0 +1,156 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <tuple>
+#include <vector>
+
+/*! @brief Handle to a sub-allocated range of device memory.
+ *
+ * 'block' indexes the allocator block the range was carved from, 'offset' and 'size' describe the range
+ * inside 'memory'. 'pMapped' points at the start of the range if the block is host visible, otherwise nullptr.
+ */
+struct Allocation
+{
+    uint32_t block;
+    VkDeviceMemory memory;
+    VkDeviceSize offset;
+    VkDeviceSize size;
+    void* pMapped;
+};
+
+/*! @brief Snapshot of allocator usage.
+ *
+ */
+struct AllocatorStats
+{
+    uint32_t blockCount;
+    uint32_t dedicatedBlockCount;
+    uint32_t allocationCount;
+    VkDeviceSize blockBytes;
+    VkDeviceSize allocationBytes;
+};
+
+/*! @brief Usage and budget of a single memory heap.
+ *
+ * 'blockBytes' and 'allocationBytes' count memory owned by this allocator. 'usage' and 'budget' come from
+ * VK_EXT_memory_budget when it is enabled and include other processes, otherwise 'usage' equals 'blockBytes'
+ * and 'budget' is estimated from the heap size.
+ */
+struct HeapBudget
+{
+    VkDeviceSize heapSize;
+    VkMemoryHeapFlags flags;
+    VkDeviceSize blockBytes;
+    VkDeviceSize allocationBytes;
+    VkDeviceSize usage;
+    VkDeviceSize budget;
+};
+
+struct MemoryBlock
+{
+    VkDeviceMemory memory;
+    uint32_t memoryTypeIndex;
+    VkDeviceSize size;
+    void* pMapped;
+    bool dedicated;
+
+    uint32_t maxOrder;
+    std::vector<std::set<VkDeviceSize>> freeLists;
+    std::map<VkDeviceSize, uint32_t> allocations;
+    VkDeviceSize usedBytes;
+};
+
+/*! @brief Buddy allocator sub-allocating buffers and images from large per memory type blocks.
+ *
+ * Each block is a power of two in size and split into power of two ranges on demand, so every range is
+ * naturally aligned to its own size. Requests too large for a block receive a dedicated allocation.
+ */
+class Allocator
+{
+public:
+
+    Allocator();
+    ~Allocator();
+
+    /*! @brief Initialises the allocator for a logical device.
+     *
+     * @param[in] physicalDevice Physical device the logical device was created from
+     * @param[in] device Logical device memory is allocated from
+     * @param[in] memoryBudgetSupported 'true' if VK_EXT_memory_budget is enabled on the device
+     */
+    void create(VkPhysicalDevice physicalDevice, VkDevice device, bool memoryBudgetSupported);
+
+    /*! @brief Frees every block owned by the allocator.
+     *
+     */
+    void destroy();
+
+    /*! @brief Sub-allocates memory satisfying the given requirements.
+     *
+     * @param[in] requirements Size, alignment and memory type bits of the resource
+     * @param[in] memoryTypeIndex Memory type to allocate from
+     * @param[in] linear 'true' for buffers and linear images, 'false' for optimally tiled images
+     *
+     * @return Handle describing the allocated range.
+     */
+    Allocation allocate(const VkMemoryRequirements& requirements, uint32_t memoryTypeIndex, bool linear);
+
+    /*! @brief Returns a range to its block and resets the handle.
+     *
+     */
+    void free(Allocation& allocation);
+
+    AllocatorStats getStats();
+
+    /*! @brief Finds the best memory type for a resource.
+     *
+     * Types missing a required flag are rejected. The remaining types are ranked by the number of preferred
+     * flags they have, then by the number of flags neither required nor preferred. Results are cached per
+     * flag combination.
+     *
+     * @param[in] typeBits Memory type bits of the resource
+     * @param[in] required Flags the memory type must have
+     * @param[in] preferred Flags the memory type should have
+     *
+     * @return Index of the memory type, UINT32_MAX if none matches.
+     */
+    uint32_t findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred);
+
+    uint32_t getHeapIndex(uint32_t memoryTypeIndex);
+    const VkPhysicalDeviceMemoryProperties& getMemoryProperties();
+
+    /*! @brief Returns usage and budget of every memory heap.
+     *
+     */
+    std::vector<HeapBudget> getBudget();
+
+protected:
+
+
+
+private:
+
+    VkPhysicalDevice physicalDevice;
+    VkDevice device;
+
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    bool memoryBudgetSupported;
+
+    std::map<std::tuple<uint32_t, VkMemoryPropertyFlags, VkMemoryPropertyFlags>, uint32_t> memoryTypeCache;
+    VkDeviceSize bufferImageGranularity;
+
+    std::vector<VkDeviceSize> blockSizes;
+    std::vector<MemoryBlock> blocks;
+
+    std::mutex mutex;
+
+    uint32_t createBlock(uint32_t memoryTypeIndex, VkDeviceSize size, bool dedicated);
+    void destroyBlock(uint32_t blockIndex);
+
+    bool allocateFromBlock(MemoryBlock& block, uint32_t order, VkDeviceSize& offset);
+    void freeToBlock(MemoryBlock& block, VkDeviceSize offset, uint32_t order);
+};
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*! @brief Order in which queued requests are started, requests of equal priority start in submission order.
+ *
+ */
+enum AssetPriority
+{
+    ASSET_PRIORITY_LOW,
+    ASSET_PRIORITY_NORMAL,
+    ASSET_PRIORITY_HIGH
+};
+
+enum AssetStatus
+{
+    ASSET_STATUS_QUEUED,
+    ASSET_STATUS_LOADING,
+    ASSET_STATUS_READY,
+    ASSET_STATUS_FAILED,
+    ASSET_STATUS_CANCELLED
+};
+
+struct AssetRequestState
+{
+    std::atomic<AssetStatus> status;
+    std::atomic<bool> cancelled;
+};
+
+/*! @brief Shared handle to the result of an asset request.
+ *
+ * Copies refer to the same request. The result stays valid as long as any handle to it exists.
+ */
+template <typename T>
+class AssetHandle
+{
+public:
+    AssetHandle()
+    {
+
+    }
+
+    AssetHandle(const std::shared_ptr<AssetRequestState>& state, const std::shared_future<T>& future) : state(state), future(future)
+    {
+
+    }
+
+    bool isValid()
+    {
+        return state != nullptr;
+    }
+
+    /*! @brief Whether the request has finished, successfully or not, without blocking.
+     *
+     */
+    bool isDone()
+    {
+        return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    AssetStatus getStatus()
+    {
+        return state->status;
+    }
+
+    /*! @brief Blocks until the request has finished.
+     *
+     * Rethrows the error of a failed or cancelled request.
+     */
+    const T& get()
+    {
+        return future.get();
+    }
+
+    /*! @brief Cancels the request if it has not finished yet.
+     *
+     * Queued requests are dropped without touching the disk, a running request is abandoned before decoding.
+     */
+    void cancel()
+    {
+        state->cancelled = true;
+    }
+
+
+
+protected:
+
+
+
+private:
+    std::shared_ptr<AssetRequestState> state;
+    std::shared_future<T> future;
+};
+
+/*! @brief Loads files on a small pool of I/O threads and decodes them on the same threads.
+ *
+ * One loader is shared by every window of an application. Completion callbacks are not run on the workers,
+ * they are queued and run by dispatchCompleted on the main thread once per frame.
+ */
+class AssetLoader
+{
+public:
+    AssetLoader();
+    ~AssetLoader();
+
+    /*! @brief Starts the I/O threads.
+     *
+     * @param[in] threadCount Number of workers, more workers keep more reads in flight
+     * @param[in] rootPath Prefix of every requested path, relative paths resolve against the working directory
+     */
+    void create(uint32_t threadCount, const std::string& rootPath = "");
+
+    /*! @brief Cancels all queued requests, waits for running ones and joins the workers.
+     *
+     */
+    void destroy();
+
+    /*! @brief Requests the raw contents of a file.
+     *
+     */
+    AssetHandle<std::vector<char>> load(const std::string& path, AssetPriority priority = ASSET_PRIORITY_NORMAL);
+
+    /*! @brief Requests a file and converts it with 'decode' on the worker that read it.
+     *
+     * @param[in] decode Called with the file contents, may take them over
+     * @param[in] onLoaded Optional, queued for dispatchCompleted once the decoded result is ready
+     */
+    template <typename T>
+    AssetHandle<T> load(const std::string& path, const std::function<T(std::vector<char>&)>& decode, AssetPriority priority = ASSET_PRIORITY_NORMAL,
+        const std::function<void(const T&)>& onLoaded = nullptr);
+
+    /*! @brief Runs completion callbacks of finished requests on the calling thread.
+     *
+     * @param[in] maxCount Upper bound of callbacks run, limits the work taken on per frame
+     * @return Number of callbacks run.
+     */
+    uint32_t dispatchCompleted(uint32_t maxCount = UINT32_MAX);
+
+    /*! @brief Number of requests queued or being loaded.
+     *
+     */
+    uint32_t getPendingCount();
+
+    uint32_t getThreadCount();
+
+    /*! @brief Reads a whole file synchronously on the calling thread.
+     *
+     */
+    static std::vector<char> readAsset(const std::string& path);
+
+
+
+protected:
+
+
+
+private:
+    struct Job
+    {
+        AssetPriority priority;
+        uint64_t sequence;
+        std::shared_ptr<AssetRequestState> state;
+        std::function<void()> run;
+
+        bool operator<(const Job& other) const;
+    };
+
+    std::vector<std::thread> threads;
+    std::string rootPath;
+
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::priority_queue<Job> jobs;
+    uint64_t nextSequence;
+    uint32_t runningJobs;
+    bool stopping;
+
+    std::mutex completedMutex;
+    std::deque<std::function<void()>> completed;
+
+    void submit(AssetPriority priority, const std::shared_ptr<AssetRequestState>& state, const std::function<void()>& run);
+    void complete(const std::function<void()>& callback);
+    void work();
+};
+
+template <typename T>
+AssetHandle<T> AssetLoader::load(const std::string& path, const std::function<T(std::vector<char>&)>& decode, AssetPriority priority,
+    const std::function<void(const T&)>& onLoaded)
+{
+    std::shared_ptr<AssetRequestState> state = std::make_shared<AssetRequestState>();
+    state->status = ASSET_STATUS_QUEUED;
+    state->cancelled = false;
+
+    std::shared_ptr<std::promise<T>> promise = std::make_shared<std::promise<T>>();
+    std::shared_future<T> future = promise->get_future().share();
+
+    std::string fullPath = rootPath + path;
+
+    submit(priority, state, [this, state, promise, future, fullPath, decode, onLoaded]()
+    {
+        try
+        {
+            if (state->cancelled)
+            {
+                throw std::runtime_error("Error! Asset request cancelled: " + fullPath);
+            }
+
+            state->status = ASSET_STATUS_LOADING;
+            std::vector<char> data = readAsset(fullPath);
+
+            if (state->cancelled)
+            {
+                throw std::runtime_error("Error! Asset request cancelled: " + fullPath);
+            }
+
+            T result = decode(data);
+
+            //status is set first so waiters woken by the future see the final status
+            state->status = ASSET_STATUS_READY;
+            promise->set_value(std::move(result));
+        }
+        catch (...)
+        {
+            state->status = state->cancelled ? ASSET_STATUS_CANCELLED : ASSET_STATUS_FAILED;
+            promise->set_exception(std::current_exception());
+            return;
+        }
+
+        if (onLoaded)
+        {
+            complete([onLoaded, future]()
+            {
+                onLoaded(future.get());
+            });
+        }
+    });
+
+    return AssetHandle<T>(state, future);
+}
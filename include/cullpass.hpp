@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <glm/glm.hpp>
+
+#include <drawlist.hpp>
+
+#include <string>
+#include <vector>
+
+class Device;
+
+/*! @brief Push constants of the culling shader, laid out as in cull.comp.
+ *
+ */
+struct CullParams
+{
+    glm::vec4 planes[6];
+    glm::vec4 viewTransform; //FrameUniforms::viewTransform, applied to instance positions before the plane tests
+    uint32_t objectCount;
+    uint32_t indexCount;
+    float boundingRadius;
+    uint32_t compact;
+};
+
+/*! @brief Compute pass testing per-object bounding spheres against a frustum and writing the visible draws.
+ *
+ * Objects are read from an instance buffer, one invocation per object. With 'compact' set visible draws are
+ * appended to the draw list through its count buffer, which requires drawing with the indirect count variant.
+ * Otherwise every object keeps its slot and culled draws get an instance count of zero.
+ */
+class CullPass
+{
+public:
+
+    CullPass();
+    ~CullPass();
+
+    /*! @brief Creates the compute pipeline and one descriptor set per frame in flight.
+     *
+     * @param[in] device Device the pass is created on
+     * @param[in] setCount Number of frames that may record the pass concurrently
+     * @param[in] shaderModule Cull compute shader from the device shader library, owned by the caller
+     */
+    void create(Device& device, uint32_t setCount, VkShaderModule shaderModule);
+    void destroy(Device& device);
+
+    /*! @brief Records culling of 'params.objectCount' objects into the draw list of a frame.
+     *
+     * The descriptor set of 'set' is rewritten, so the frame using it must have completed.
+     */
+    void record(Device& device, VkCommandBuffer commandBuffer, uint32_t set, VkBuffer instanceBuffer, DrawList& drawList, const CullParams& params);
+
+protected:
+
+
+
+private:
+
+    VkDescriptorSetLayout setLayout;
+    VkDescriptorPool descriptorPool;
+    std::vector<VkDescriptorSet> descriptorSets;
+
+    VkPipelineLayout layout;
+    VkPipeline pipeline;
+
+    uint32_t groupSize; //local size of the shader, reflected
+};
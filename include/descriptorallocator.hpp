@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+class Device;
+
+/*! @brief Hands out descriptor sets from a growing list of pools that are reset all at once.
+ *
+ * Sets are never freed individually, reset() returns every pool to the free list after the work using the
+ * sets has completed. When the current pool runs out another one is taken or created, so the number of sets
+ * allocated between resets is not bounded by the size of one pool. Not thread safe, use one per thread.
+ */
+class DescriptorAllocator
+{
+public:
+
+    DescriptorAllocator();
+    ~DescriptorAllocator();
+
+    /*! @brief Sets the size of the pools, none is created yet.
+     *
+     * @param[in] poolSizes Descriptors of each type in one pool
+     * @param[in] maxSets Sets allocated from one pool
+     */
+    void create(const std::vector<VkDescriptorPoolSize>& poolSizes, uint32_t maxSets);
+    void destroy(Device& device);
+
+    VkDescriptorSet allocate(Device& device, VkDescriptorSetLayout layout);
+
+    /*! @brief Resets every pool, sets allocated from them must no longer be in use.
+     *
+     */
+    void reset(Device& device);
+
+    uint32_t getPoolCount();
+
+protected:
+
+
+
+private:
+
+    std::vector<VkDescriptorPoolSize> poolSizes;
+    uint32_t maxSets;
+
+    std::vector<VkDescriptorPool> usedPools;
+    std::vector<VkDescriptorPool> freePools;
+
+    VkDescriptorPool acquirePool(Device& device);
+};
@@ -2,9 +2,20 @@
 
 #include <vulkan/vulkan.h>
 
+#include <allocator.hpp>
+#include <layoutcache.hpp>
+#include <pipelinecache.hpp>
+#include <profiler.hpp>
+#include <shaderlibrary.hpp>
+#include <staging.hpp>
+#include <transfer.hpp>
+
 #include <map>
+#include <mutex>
 #include <vector>
 
+class GeometryCache;
+
 struct QueueFamily
 {
     uint32_t queueFamilyIndex;
@@ -18,6 +29,19 @@ struct Queue
     QueueFamily family;
 };
 
+struct UploadToken
+{
+    uint64_t serial;
+};
+
+struct PendingAcquire
+{
+    uint64_t serial;
+    VkSemaphore semaphore;
+    std::vector<VkBufferMemoryBarrier> bufferBarriers;
+    std::vector<VkImageMemoryBarrier> imageBarriers;
+};
+
 struct SwapchainSupportDetails
 {
     VkSurfaceCapabilitiesKHR capabilities;
@@ -32,15 +56,32 @@ public:
     Device();
     ~Device();
 
+    /*! @brief Creates the logical device.
+     *
+     * Passing VK_NULL_HANDLE as 'surface' selects a device for headless rendering, present support and
+     * the swapchain extension are then not required.
+     */
     void create(VkSurfaceKHR& surface);
     void destroy();
 
-    void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& memory);
+    void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, Allocation& allocation);
     VkResult createBuffer(VkBufferCreateInfo* pCreateInfo, VkAllocationCallbacks* pAllocator, VkBuffer* pBuffer);
+    void createBuffer(VkBufferCreateInfo* pCreateInfo, VkMemoryPropertyFlags properties, VkBuffer& buffer, Allocation& allocation);
+
+    /*! @brief Creates a buffer the graphics and compute queues use without ownership transfers.
+     *
+     * Concurrent sharing is used when the two queues are in different families, buffers written on one queue
+     * and read on the other every frame then only need the semaphore between the submissions.
+     */
+    void createSharedBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, Allocation& allocation);
+    void createImage(VkImageCreateInfo* pCreateInfo, VkMemoryPropertyFlags properties, VkImage& image, Allocation& allocation);
     VkResult createCommandPool(VkCommandPoolCreateInfo* pCreateInfo, VkAllocationCallbacks* pAllocator, VkCommandPool* pPool);
+    VkResult createComputePipelines(VkPipelineCache cache, uint32_t createInfoCount, const VkComputePipelineCreateInfo* pCreateInfos, VkAllocationCallbacks* pAllocator, VkPipeline* pPipelines);
+    VkResult createDescriptorPool(VkDescriptorPoolCreateInfo* pCreateInfo, VkAllocationCallbacks* pAllocator, VkDescriptorPool* pPool);
+    VkResult createDescriptorSetLayout(VkDescriptorSetLayoutCreateInfo* pCreateInfo, VkAllocationCallbacks* pAllocator, VkDescriptorSetLayout* pLayout);
     VkResult createFence(VkFenceCreateInfo* pCreateInfo, VkAllocationCallbacks* pAllocator, VkFence* pFence);
     VkResult createFramebuffer(VkFramebufferCreateInfo* pCreateInfo, VkAllocationCallbacks* pAllocator, VkFramebuffer* pFramebuffer);
-    VkResult createGraphicsPipelines(VkPipelineCache pipelineCache, uint32_t createInfoCount, const VkGraphicsPipelineCreateInfo* pCreateInfos, VkAllocationCallbacks* pAllocator, VkPipeline* pPipelines);
+    VkResult createGraphicsPipelines(VkPipelineCache cache, uint32_t createInfoCount, const VkGraphicsPipelineCreateInfo* pCreateInfos, VkAllocationCallbacks* pAllocator, VkPipeline* pPipelines);
     VkResult createImageView(VkImageViewCreateInfo* pCreateInfo, VkAllocationCallbacks* pAllocator, VkImageView* pImageView);
     VkResult createPipelineLayout(VkPipelineLayoutCreateInfo* pCreateInfo, VkAllocationCallbacks* pAllocator, VkPipelineLayout* pLayout);
     VkResult createRenderPass(VkRenderPassCreateInfo* pCreateInfo, VkAllocationCallbacks* pAllocator, VkRenderPass* pRenderPass);
@@ -52,13 +93,38 @@ public:
     VkResult bindBufferMemory(VkBuffer buffer, VkDeviceMemory memory, VkDeviceSize offset);
     void freeMemory(VkDeviceMemory memory, VkAllocationCallbacks* pAllocator);
 
+    VkResult allocateDescriptorSets(VkDescriptorSetAllocateInfo* pAllocInfo, VkDescriptorSet* pSets);
+    VkResult resetDescriptorPool(VkDescriptorPool pool, VkDescriptorPoolResetFlags flags);
+    void updateDescriptorSets(uint32_t writeCount, const VkWriteDescriptorSet* pWrites);
+
     VkResult allocateCommandBuffers(VkCommandBufferAllocateInfo* pAllocInfo, VkCommandBuffer* pBuffers);
+    VkResult resetCommandPool(VkCommandPool pool, VkCommandPoolResetFlags flags);
     void freeCommandBuffers(VkCommandPool pool, uint32_t bufferCount, VkCommandBuffer* pBuffers);
 
     void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkCommandPool pool, VkQueue queue);
+    void uploadBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* pData, VkDeviceSize size);
+
+    UploadToken uploadBufferAsync(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* pData, VkDeviceSize size);
+
+    /*! @brief Copies 'pData' into the staging ring and adds the copy to 'batch'.
+     *
+     * The batch holds the upload lock of the device from its first staged region until submitTransfers(), so regions
+     * of batches built on different threads are never tied to the wrong submission.
+     */
+    void stageBuffer(TransferBatch& batch, VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* pData, VkDeviceSize size);
+    void stageImage(TransferBatch& batch, VkImage dstImage, VkImageLayout dstLayout, const VkBufferImageCopy& region, const void* pData, VkDeviceSize size);
+    UploadToken submitTransfers(TransferBatch& batch);
+
+    bool isUploadComplete(UploadToken token);
+    void waitForUpload(UploadToken token);
+    void acquireUpload(UploadToken token);
 
     void destroyBuffer(VkBuffer buffer, VkAllocationCallbacks* pAllocator);
+    void destroyBuffer(VkBuffer buffer, Allocation& allocation);
+    void destroyImage(VkImage image, Allocation& allocation);
     void destroyCommandPool(VkCommandPool pool, VkAllocationCallbacks* pAllocator);
+    void destroyDescriptorPool(VkDescriptorPool pool, VkAllocationCallbacks* pAllocator);
+    void destroyDescriptorSetLayout(VkDescriptorSetLayout layout, VkAllocationCallbacks* pAllocator);
     void destroyFence(VkFence fence, VkAllocationCallbacks* pAllocator);
     void destroyFramebuffer(VkFramebuffer framebuffer, VkAllocationCallbacks* pAllocator);
     void destroyImageView(VkImageView view, VkAllocationCallbacks* pAllocator);
@@ -78,10 +144,29 @@ public:
     VkResult waitForFences(uint32_t fenceCount, VkFence* pFences, VkBool32 waitAll, uint64_t timeout);
     VkResult resetFences(uint32_t fenceCount, VkFence* pFences);
 
+    /*! @brief Waits for every queue to drain, holding all queue locks.
+     *
+     */
     VkResult waitIdle();
 
+    /*! @brief Submits to 'queue' while holding its lock.
+     *
+     * Windows rendering on different threads share the queues of their device, Vulkan requires submissions
+     * and presents to a queue to be externally synchronised. Every submission must go through these calls.
+     */
+    VkResult queueSubmit(VkQueue queue, uint32_t submitCount, const VkSubmitInfo* pSubmits, VkFence fence);
+    VkResult queuePresent(VkQueue queue, const VkPresentInfoKHR* pPresentInfo);
+    VkResult queueWaitIdle(VkQueue queue);
+
     int getRating(VkSurfaceKHR& surface);
 
+    /*! @brief Checks whether the device can present to 'surface', so a window on it may reuse the device.
+     *
+     * The queue family frames are presented from must support the surface, and the swapchain extension must
+     * be enabled. Any device supports VK_NULL_HANDLE, headless windows never present.
+     */
+    bool isSurfaceSupported(VkSurfaceKHR& surface);
+
     void getBufferMemoryRequirements(VkBuffer buffer, VkMemoryRequirements* pRequirements);
     void getPhysicalDeviceMemoryProperties(VkPhysicalDeviceMemoryProperties* pProperties);
 
@@ -91,9 +176,86 @@ public:
     VkBool32 getPhysicalDeviceSurfaceSupport(VkSurfaceKHR& surface);
     SwapchainSupportDetails getSwapchainSupportDetails(VkSurfaceKHR& surface);
     std::vector<Queue>& getGraphicsQueues();
+    std::vector<Queue>& getComputeQueues();
     VkCommandPool getCommandPool(Queue queue);
 
+    /*! @brief Returns the alignment required of uniform buffer offsets, dynamic offsets included.
+     *
+     */
+    VkDeviceSize getMinUniformBufferOffsetAlignment();
+
     uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+    uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred);
+
+    /*! @brief Creates a timestamp profiler for command buffers submitted to the first graphics queue.
+     *
+     * @param[in] slotCount Number of frame slots, usually one per command buffer recorded ahead
+     * @param[in] maxScopes Maximum number of scopes per slot
+     */
+    GpuProfiler* createProfiler(uint32_t slotCount, uint32_t maxScopes);
+    void destroyProfiler(GpuProfiler* profiler);
+
+    /*! @brief Returns the disk backed pipeline cache of the calling thread.
+     *
+     */
+    VkPipelineCache getPipelineCache();
+
+    /*! @brief Returns the shader modules shared by every window on the device.
+     *
+     */
+    ShaderLibrary* getShaderLibrary();
+
+    /*! @brief Returns the descriptor set and pipeline layouts shared by every pipeline on the device.
+     *
+     */
+    LayoutCache* getLayoutCache();
+
+    /*! @brief Returns the vertex and index buffers shared by every window on the device.
+     *
+     */
+    GeometryCache* getGeometryCache();
+
+    AllocatorStats getAllocatorStats();
+    PipelineCacheStats getPipelineCacheStats();
+
+    /*! @brief Returns usage and budget of every memory heap of the device.
+     *
+     */
+    std::vector<HeapBudget> getMemoryBudget();
+
+    /*! @brief Checks whether 'size' more bytes fit the budget of the heap backing 'properties'.
+     *
+     * Intended for throttling streaming before the heap runs out of memory.
+     */
+    bool isWithinBudget(VkMemoryPropertyFlags properties, VkDeviceSize size);
+
+    /*! @brief Returns 'true' if VK_EXT_extended_dynamic_state is enabled on the device.
+     *
+     * Only then may pipelines declare cull mode, front face and topology as dynamic and the cmdSet*() calls below be used.
+     */
+    bool isExtendedDynamicStateSupported();
+
+    void cmdSetCullMode(VkCommandBuffer commandBuffer, VkCullModeFlags cullMode);
+    void cmdSetFrontFace(VkCommandBuffer commandBuffer, VkFrontFace frontFace);
+    void cmdSetPrimitiveTopology(VkCommandBuffer commandBuffer, VkPrimitiveTopology topology);
+
+    /*! @brief Returns 'true' if multiDrawIndirect is enabled.
+     *
+     * Without it every indirect draw must be issued with a draw count of one.
+     */
+    bool isMultiDrawIndirectSupported();
+
+    /*! @brief Returns 'true' if indirect draws may use a first instance other than zero.
+     *
+     */
+    bool isDrawIndirectFirstInstanceSupported();
+
+    /*! @brief Returns 'true' if VK_KHR_draw_indirect_count is enabled and cmdDrawIndexedIndirectCount() may be used.
+     *
+     */
+    bool isDrawIndirectCountSupported();
+
+    void cmdDrawIndexedIndirectCount(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countBufferOffset, uint32_t maxDrawCount, uint32_t stride);
 
     VkResult acquireNextImageKHR(VkSwapchainKHR swapchain, uint64_t timeout, VkSemaphore semaphore, VkFence fence, uint32_t* pImageIndex);
 
@@ -112,4 +274,37 @@ private:
 
     std::map<uint32_t, VkCommandPool> commandPools;
 
+    //only recorded into while holding uploadMutex, so uploads never race other users of commandPools
+    std::map<uint32_t, VkCommandPool> uploadPools;
+
+    //shared by every copy of the device, one lock per distinct VkQueue
+    std::map<VkQueue, std::mutex>* queueMutexes;
+
+    Allocator* allocator;
+    PipelineCache* pipelineCache;
+    ShaderLibrary* shaderLibrary;
+    LayoutCache* layoutCache;
+    GeometryCache* geometryCache;
+
+    StagingRing* stagingRing;
+    VkBuffer stagingBuffer;
+    Allocation stagingBufferAllocation;
+
+    //held from the first staged region of a batch until its submission, and by anything freeing upload command buffers
+    std::recursive_mutex* uploadMutex;
+
+    std::vector<PendingAcquire> pendingAcquires;
+    uint64_t lastUploadSerial;
+
+    bool extendedDynamicStateSupported;
+    PFN_vkCmdSetCullModeEXT pfnCmdSetCullMode;
+    PFN_vkCmdSetFrontFaceEXT pfnCmdSetFrontFace;
+    PFN_vkCmdSetPrimitiveTopologyEXT pfnCmdSetPrimitiveTopology;
+
+    bool swapchainSupported;
+
+    VkPhysicalDeviceFeatures enabledFeatures;
+    bool drawIndirectCountSupported;
+    PFN_vkCmdDrawIndexedIndirectCountKHR pfnCmdDrawIndexedIndirectCount;
+
 };
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <device.hpp>
+
+#include <vector>
+
+/*! @brief Logical devices of an application, shared by every window able to render on them.
+ *
+ * A window is handed an existing device whenever that device can present to its surface, so pools, caches,
+ * pipelines and geometry are created once per device rather than once per window. A new device is only
+ * created for surfaces no existing device supports.
+ */
+class DeviceRegistry
+{
+public:
+
+    DeviceRegistry();
+    ~DeviceRegistry();
+
+    void create();
+
+    /*! @brief Destroys every device, windows using them must be destroyed first.
+     *
+     */
+    void destroy();
+
+    /*! @brief Returns the best rated device supporting 'surface', creating one if none does.
+     *
+     * Passing VK_NULL_HANDLE accepts any device. The device stays owned by the registry.
+     */
+    Device* acquire(VkSurfaceKHR& surface);
+
+    const std::vector<Device*>& getDevices();
+
+protected:
+
+
+
+private:
+
+    std::vector<Device*> devices;
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <allocator.hpp>
+
+#include <vector>
+
+class Device;
+
+/*! @brief List of indexed draws submitted from a device buffer instead of being recorded one by one.
+ *
+ * Draws are collected on the CPU, written to a host visible indirect buffer by upload() and issued by record()
+ * with a single vkCmdDrawIndexedIndirect, or vkCmdDrawIndexedIndirectCount where supported. All draws of a list
+ * share the pipeline and vertex buffers bound when it is recorded. The buffers may also be written by a compute
+ * pass, which is why they are created as storage buffers as well.
+ */
+class DrawList
+{
+public:
+
+    DrawList();
+    ~DrawList();
+
+    /*! @brief Creates the command and count buffers.
+     *
+     * @param[in] device Device the buffers are created on
+     * @param[in] capacity Initial number of draws the command buffer holds, grown by upload() if exceeded
+     */
+    void create(Device& device, uint32_t capacity);
+    void destroy(Device& device);
+
+    void clear();
+    void addDraw(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance);
+    uint32_t getDrawCount();
+
+    /*! @brief Writes the collected draws and their count to the device buffers.
+     *
+     * The buffers must not be in use by the GPU, call this after the frame's fence has signalled.
+     */
+    void upload(Device& device);
+
+    /*! @brief Prepares the buffers for 'drawCount' draws written on the GPU instead of by upload().
+     *
+     * The buffers must not be in use by the GPU.
+     */
+    void reserve(Device& device, uint32_t drawCount);
+
+    /*! @brief Records the uploaded draws into a command buffer.
+     *
+     * @return Number of draw commands recorded, one unless multi draw indirect is unavailable.
+     */
+    uint32_t record(Device& device, VkCommandBuffer commandBuffer);
+
+    VkBuffer getCommandBuffer();
+    VkBuffer getCountBuffer();
+    uint32_t getCapacity();
+
+protected:
+
+
+
+private:
+
+    std::vector<VkDrawIndexedIndirectCommand> draws;
+    uint32_t uploadedCount;
+
+    uint32_t capacity;
+    VkBuffer commandBuffer;
+    Allocation commandAllocation;
+    VkBuffer countBuffer;
+    Allocation countAllocation;
+
+    void createCommandBuffer(Device& device);
+};
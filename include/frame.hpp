@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <descriptorallocator.hpp>
+
+#include <vector>
+
+class Device;
+
+/*! @brief Transient command pool of a single thread and the command buffers allocated from it.
+ *
+ * Buffers are kept across frames and handed out again after the pool has been reset.
+ */
+struct ThreadCommandPool
+{
+    VkCommandPool pool;
+
+    std::vector<VkCommandBuffer> primaryBuffers;
+    std::vector<VkCommandBuffer> secondaryBuffers;
+    uint32_t primaryUsed;
+    uint32_t secondaryUsed;
+};
+
+/*! @brief Command recording resources of one frame in flight.
+ *
+ * Owns one transient command pool and one descriptor allocator per recording thread. Pool 0 belongs to the
+ * thread submitting the frame, pool 'i + 1' to worker 'i'. All pools are reset at once when the frame's fence
+ * has signalled, so command buffers are re-recorded and descriptor sets re-allocated every frame without
+ * freeing them one by one.
+ */
+class FrameContext
+{
+public:
+
+    FrameContext();
+    ~FrameContext();
+
+    /*! @brief Creates the command pools.
+     *
+     * @param[in] device Device the pools are created on
+     * @param[in] queueFamilyIndex Queue family the recorded command buffers are submitted to
+     * @param[in] threadCount Number of recording threads including the submitting thread
+     */
+    void create(Device& device, uint32_t queueFamilyIndex, uint32_t threadCount);
+    void destroy(Device& device);
+
+    /*! @brief Resets every pool, the frame's previous submission must have completed.
+     *
+     */
+    void reset(Device& device);
+
+    /*! @brief Returns a primary command buffer from the pool of 'thread', ready to be begun.
+     *
+     */
+    VkCommandBuffer getPrimaryBuffer(Device& device, uint32_t thread);
+
+    /*! @brief Returns a secondary command buffer from the pool of 'thread', ready to be begun.
+     *
+     * Each thread may only call this with its own index, pools are not shared between threads.
+     */
+    VkCommandBuffer getSecondaryBuffer(Device& device, uint32_t thread);
+
+    /*! @brief Allocates a descriptor set valid until the next reset from the pools of 'thread'.
+     *
+     */
+    VkDescriptorSet allocateDescriptorSet(Device& device, uint32_t thread, VkDescriptorSetLayout layout);
+
+    uint32_t getThreadCount();
+
+protected:
+
+
+
+private:
+
+    std::vector<ThreadCommandPool> threadPools;
+    std::vector<DescriptorAllocator> descriptorAllocators;
+
+    VkCommandBuffer getBuffer(Device& device, ThreadCommandPool& threadPool, VkCommandBufferLevel level);
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <allocator.hpp>
+#include <device.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+
+/*! @brief Device local vertex and index buffers of one mesh, with the upload that fills them.
+ *
+ */
+struct GeometryBuffers
+{
+    VkBuffer vertexBuffer;
+    VkBuffer indexBuffer;
+    Allocation vertexBufferAllocation;
+    Allocation indexBufferAllocation;
+    UploadToken upload;
+};
+
+struct GeometryCacheStats
+{
+    uint32_t meshCount;    //meshes alive
+    uint64_t createdCount; //meshes uploaded
+    uint64_t reusedCount;  //acquisitions served by an uploaded mesh
+};
+
+/*! @brief Reference counted geometry of a device, keyed by the mesh and the format it was packed in.
+ *
+ * Windows drawing the same mesh share one copy of its buffers instead of uploading their own. Buffers are
+ * destroyed when their last reference is released. The buffers are read only once uploaded, so sharing them
+ * between windows rendering on different threads needs no further synchronisation.
+ */
+class GeometryCache
+{
+public:
+
+    GeometryCache();
+    ~GeometryCache();
+
+    void create();
+
+    /*! @brief Destroys every buffer, references still held are reported.
+     *
+     */
+    void destroy(Device& device);
+
+    /*! @brief Returns the buffers stored under 'key' and adds a reference.
+     *
+     * @param[in] create Called on first use to create the buffers and start their upload
+     */
+    GeometryBuffers acquire(const std::string& key, const std::function<GeometryBuffers()>& create);
+
+    void release(Device& device, VkBuffer vertexBuffer);
+
+    GeometryCacheStats getStats();
+
+protected:
+
+
+
+private:
+
+    struct GeometryEntry
+    {
+        GeometryBuffers buffers;
+        uint32_t refCount;
+    };
+
+    std::map<std::string, GeometryEntry> entries;
+    std::map<VkBuffer, std::string> keys;
+
+    uint64_t createdCount;
+    uint64_t reusedCount;
+
+    std::mutex mutex;
+};
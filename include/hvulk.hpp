@@ -3,6 +3,9 @@
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
+#include <assetloader.hpp>
+#include <deviceregistry.hpp>
+#include <threadpool.hpp>
 #include <window.hpp>
 
 /*! @brief Definition of standard application.
@@ -26,7 +29,8 @@ public:
     /*! @brief Initialises application startup.
      *
      * This function initialises the application then transistions into the primary program loop. 
-     * Calls virtual function start(). 
+     * Calls virtual function start(). Every window records and submits its frame on its own thread,
+     * frames are then presented together. The loop ends when the primary window closes.
      */ 
     void run();
 
@@ -37,10 +41,23 @@ protected:
      */
     virtual void start(Window& primaryWindow) = 0;
 
+    /*! @brief Adds a window launched and rendered together with the primary window.
+     *
+     * Must be called from start(). The window stays valid until the application is destroyed.
+     */
+    Window& createWindow();
+
 private:
 
-    std::vector<Window> windows;
-    std::vector<Device> devices;
+    std::vector<Window*> windows;
+    DeviceRegistry deviceRegistry;
+
+    //shared by every window, its callbacks run on the main thread before windows prepare their frames
+    AssetLoader assetLoader;
+
+    ThreadPool* windowThreads;
+
+    bool glfwInitialised;
 
 };
 
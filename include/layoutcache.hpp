@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <spirvreflect.hpp>
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/*! @brief Pipeline layout built from the reflected stages of a pipeline, owned by the layout cache.
+ *
+ */
+struct PipelineLayoutInfo
+{
+    VkPipelineLayout layout;
+    std::vector<VkDescriptorSetLayout> setLayouts; //indexed by set, sets no stage uses have an empty layout
+    std::vector<std::vector<VkDescriptorSetLayoutBinding>> setBindings;
+    std::vector<VkPushConstantRange> pushConstantRanges;
+};
+
+struct LayoutCacheStats
+{
+    uint32_t setLayoutCount;
+    uint32_t pipelineLayoutCount;
+};
+
+/*! @brief Descriptor set and pipeline layouts of a device, deduplicated by their contents.
+ *
+ * Pipelines whose shaders declare the same bindings get the same VkDescriptorSetLayout and VkPipelineLayout,
+ * so descriptor sets bound for one stay valid after switching to the other. Layouts live until the device is
+ * destroyed, callers never destroy them.
+ */
+class LayoutCache
+{
+public:
+
+    LayoutCache();
+    ~LayoutCache();
+
+    void create(VkDevice device);
+    void destroy();
+
+    /*! @brief Returns the set layout with exactly 'bindings', in any order.
+     *
+     */
+    VkDescriptorSetLayout getSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+
+    /*! @brief Returns the pipeline layout of a pipeline made of 'stages'.
+     *
+     * Bindings declared by several stages are merged into one binding visible to all of them, they must agree
+     * on type and count. Push constant blocks become one range starting at zero visible to every stage using one.
+     *
+     * @param[in] dynamicUniformBuffers Declare uniform buffers as UNIFORM_BUFFER_DYNAMIC, SPIR-V does not tell them apart
+     */
+    PipelineLayoutInfo getPipelineLayout(const std::vector<ShaderReflection>& stages, bool dynamicUniformBuffers = false);
+
+    LayoutCacheStats getStats();
+
+protected:
+
+
+
+private:
+
+    //binding, type, count, stages
+    typedef std::vector<std::array<uint32_t, 4>> SetLayoutKey;
+    //offset, size, stages
+    typedef std::pair<std::vector<VkDescriptorSetLayout>, std::vector<std::array<uint32_t, 3>>> PipelineLayoutKey;
+
+    VkDevice device;
+
+    std::map<SetLayoutKey, VkDescriptorSetLayout> setLayouts;
+    std::map<PipelineLayoutKey, VkPipelineLayout> pipelineLayouts;
+
+    std::mutex mutex;
+
+    VkDescriptorSetLayout getSetLayoutLocked(const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vertex.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/*! @brief Post-transform vertex cache statistics of an index buffer.
+ *
+ * 'acmr' is the average number of cache misses per triangle (0.5 is ideal for large regular meshes, 3 the
+ * worst case), 'atvr' the number of misses per referenced vertex (1 is ideal).
+ */
+struct MeshStats
+{
+    uint32_t triangleCount;
+    uint32_t vertexCount;
+    uint32_t cacheMisses;
+    float acmr;
+    float atvr;
+};
+
+struct MeshReport
+{
+    MeshStats before;
+    MeshStats after;
+};
+
+/*! @brief Simulates a FIFO post-transform cache over an index buffer.
+ *
+ * @param[in] indices Triangle list
+ * @param[in] vertexCount Number of vertices the indices refer to
+ * @param[in] cacheSize Number of entries of the simulated cache
+ */
+MeshStats analyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize = 32);
+
+/*! @brief Merges vertices that compare equal and rewrites the indices to match.
+ *
+ * An empty index buffer is treated as an unindexed triangle list and generated.
+ *
+ * @return Number of unique vertices.
+ */
+uint32_t deduplicateVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+/*! @brief Reorders triangles for post-transform cache hits with Tom Forsyth's linear-speed algorithm.
+ *
+ */
+void optimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize = 32);
+
+/*! @brief Reorders clusters of triangles front to back to reduce overdraw.
+ *
+ * Clusters are split where the cache is cold, so reordering them costs few extra misses. The new order is
+ * only kept if its ACMR stays within 'threshold' times the ACMR of the input.
+ *
+ * @param[in] positions Position of every vertex
+ */
+void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<glm::vec3>& positions, float threshold = 1.05f, uint32_t cacheSize = 32);
+
+/*! @brief Reorders vertices by first use so vertex fetch walks memory linearly.
+ *
+ * Vertices not referenced by any index are dropped.
+ */
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+/*! @brief Runs deduplication, cache, optional overdraw and fetch optimisation in that order.
+ *
+ * Vertex positions are two dimensional, so every triangle lies in the z = 0 plane and has no front to back
+ * order. optimizeOverdraw() would keep the order unchanged, so 'overdraw' is currently ignored.
+ *
+ * @return Cache statistics of the input and of the optimised mesh.
+ */
+MeshReport optimizeMesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, bool overdraw = false);
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vertex.hpp>
+#include <vertexformat.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+const uint32_t MESH_FILE_MAGIC = 0x48534d48; //"HMSH" read as little endian
+const uint32_t MESH_FILE_VERSION = 1;
+const uint32_t MESH_FILE_ALIGNMENT = 64;
+
+/*! @brief Header at the start of a binary mesh file.
+ *
+ * The vertex and index streams follow at aligned offsets, stored in the layout they are uploaded in so they can
+ * be copied from the mapped file into staging memory without conversion. All values are little endian.
+ */
+struct MeshFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertexFormat; //VertexFormat of the vertex stream
+    uint32_t vertexStride;
+    uint32_t vertexCount;
+    uint32_t indexSize;    //2 or 4 bytes
+    uint32_t indexCount;
+    uint32_t reserved;
+    uint64_t vertexOffset; //from the start of the file
+    uint64_t indexOffset;
+    float boundsMin[3];
+    float boundsMax[3];
+    float radius;          //bounding sphere around the origin
+    uint32_t padding;
+};
+
+static_assert(sizeof(MeshFileHeader) == 80, "Mesh file header layout changed");
+
+/*! @brief Read-only view of a binary mesh file, either mapped or already read into memory.
+ *
+ * The streams are only valid between create and destroy. Mapped pages are read in on first access, so copying a
+ * stream straight into a staging buffer is the only copy made of the data.
+ */
+class MeshFile
+{
+public:
+    MeshFile();
+    ~MeshFile();
+
+    /*! @brief Maps the file and validates the header against the file size.
+     *
+     * Files with an index referring past the last vertex are rejected as well.
+     */
+    void create(const std::string& path);
+
+    /*! @brief Takes over the contents of a mesh file read elsewhere, e.g. by the asset loader, and validates them.
+     *
+     * @param[in] path Only used in error messages
+     */
+    void create(std::vector<char>& data, const std::string& path);
+    void destroy();
+
+    const MeshFileHeader& getHeader();
+    VertexFormat getVertexFormat();
+    VkIndexType getIndexType();
+
+    const void* getVertexData();
+    VkDeviceSize getVertexDataSize();
+    const void* getIndexData();
+    VkDeviceSize getIndexDataSize();
+
+
+
+protected:
+
+
+
+private:
+    const uint8_t* pMapped;
+    size_t mappedSize;
+    bool mapped;
+
+    std::vector<char> contents;
+
+    MeshFileHeader header;
+
+    void validate(const std::string& path);
+};
+
+/*! @brief Writes vertices packed into 'format' and indices as a binary mesh file.
+ *
+ * Indices are stored as 16 bit if every vertex can be addressed with them. The file is written to a temporary
+ * path and renamed, so readers never see a partial file.
+ */
+void writeMeshFile(const std::string& path, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, VertexFormat format);
+
+/*! @brief Parses a Wavefront OBJ file into a triangle list.
+ *
+ * Positions keep x and y, per vertex colors ("v x y z r g b") are read if present and default to white.
+ * Polygons are triangulated as fans, texture coordinates and normals are ignored.
+ */
+void loadObjFile(const std::string& path, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
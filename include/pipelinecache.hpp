@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct PipelineCacheStats
+{
+    bool warm;              //seeded from a compatible blob on disk
+    uint32_t pipelineCount; //pipelines created through the cache
+    double creationSeconds; //time spent creating them
+};
+
+/*! @brief Disk backed VkPipelineCache shared by every pipeline created on a device.
+ *
+ * The blob stored on disk is only used if its header matches the vendor, device and cache UUID of the
+ * physical device. Threads creating pipelines get their own cache which is merged back before saving.
+ */
+class PipelineCache
+{
+public:
+
+    PipelineCache();
+    ~PipelineCache();
+
+    /*! @brief Creates the cache, seeding it from 'path' if a compatible blob exists.
+     *
+     * @param[in] physicalDevice Physical device the logical device was created from
+     * @param[in] device Logical device owning the cache
+     * @param[in] path File the cache is loaded from and saved to
+     */
+    void create(VkPhysicalDevice physicalDevice, VkDevice device, const std::string& path);
+
+    /*! @brief Merges all thread caches, writes the blob back to disk and destroys the caches.
+     *
+     */
+    void destroy();
+
+    /*! @brief Returns the cache of the calling thread, creating it on first use.
+     *
+     */
+    VkPipelineCache getThreadCache();
+
+    /*! @brief Merges every thread cache into the primary cache.
+     *
+     */
+    void merge();
+
+    /*! @brief Writes the primary cache to disk through a temporary file so a crash never leaves a torn blob.
+     *
+     */
+    void save();
+
+    /*! @brief Accumulates time spent creating pipelines, reported by getStats().
+     *
+     */
+    void recordCreation(uint32_t pipelineCount, double seconds);
+
+    bool isWarm();
+
+    PipelineCacheStats getStats();
+
+protected:
+
+
+
+private:
+
+    VkDevice device;
+    VkPhysicalDeviceProperties properties;
+
+    std::string path;
+    bool warm;
+
+    uint32_t pipelineCount;
+    double creationSeconds;
+
+    VkPipelineCache cache;
+    std::map<std::thread::id, VkPipelineCache> threadCaches;
+
+    std::mutex mutex;
+
+    bool validateHeader(const std::vector<char>& data);
+};
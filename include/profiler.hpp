@@ -0,0 +1,112 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*! @brief Rolling GPU timings of a named scope in milliseconds.
+ *
+ */
+struct ScopeStats
+{
+    uint32_t sampleCount;
+    double min;
+    double avg;
+    double p99;
+    double max;
+};
+
+struct ProfilerScope
+{
+    std::string name;
+    uint32_t beginQuery;
+};
+
+/*! @brief GPU profiler measuring named scopes with timestamp queries.
+ *
+ * Queries are partitioned into frame slots which are reset at the start of the command buffer using the slot.
+ * Results of a slot are read back once the fence of its submission has signalled, typically when the slot is
+ * reused a few frames later, so resolving never stalls the GPU. The last 'HISTORY_SIZE' samples of every
+ * scope are kept for statistics.
+ */
+class GpuProfiler
+{
+public:
+
+    GpuProfiler();
+    ~GpuProfiler();
+
+    /*! @brief Creates the query pool.
+     *
+     * @param[in] device Logical device owning the query pool
+     * @param[in] timestampPeriod Nanoseconds per timestamp tick
+     * @param[in] timestampValidBits Valid bits of timestamps written on the profiled queue, 0 disables profiling
+     * @param[in] slotCount Number of frame slots
+     * @param[in] maxScopes Maximum number of scopes per slot
+     */
+    void create(VkDevice device, float timestampPeriod, uint32_t timestampValidBits, uint32_t slotCount, uint32_t maxScopes);
+    void destroy();
+
+    /*! @brief Records the reset of all queries of a slot, must be outside a render pass.
+     *
+     */
+    void reset(VkCommandBuffer commandBuffer, uint32_t slot);
+
+    /*! @brief Records the start of a named scope.
+     *
+     * @return Scope handle to pass to endScope().
+     */
+    uint32_t beginScope(VkCommandBuffer commandBuffer, uint32_t slot, const std::string& name, VkPipelineStageFlagBits stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+    void endScope(VkCommandBuffer commandBuffer, uint32_t slot, uint32_t scope, VkPipelineStageFlagBits stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+    /*! @brief Marks a slot as submitted so its results are read by the next resolve().
+     *
+     */
+    void markSubmitted(uint32_t slot);
+
+    /*! @brief Reads back the results of a slot without waiting.
+     *
+     * Must be called after the fence of the slot's last submission has signalled. Unavailable results are skipped.
+     */
+    void resolve(uint32_t slot);
+
+    std::vector<std::string> getScopeNames();
+    ScopeStats getStats(const std::string& name);
+
+    /*! @brief Writes the statistics of every scope to a file.
+     *
+     * @param[in] path File to write, JSON if it ends in ".json", otherwise CSV
+     *
+     * @return 'true' on success.
+     */
+    bool dump(const std::string& path);
+
+    bool isEnabled();
+
+protected:
+
+
+
+private:
+
+    VkDevice device;
+    VkQueryPool queryPool;
+
+    double timestampPeriod;
+    uint64_t timestampMask;
+    bool enabled;
+
+    uint32_t slotCount;
+    uint32_t maxScopes;
+
+    std::vector<std::vector<ProfilerScope>> slotScopes;
+    std::vector<bool> slotSubmitted;
+
+    std::map<std::string, std::deque<double>> history;
+
+    std::mutex mutex;
+};
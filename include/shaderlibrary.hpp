@@ -0,0 +1,105 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <spirvreflect.hpp>
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct ShaderLibraryStats
+{
+    uint32_t moduleCount;  //modules alive
+    uint64_t createdCount; //modules created by the driver
+    uint64_t reusedCount;  //acquisitions served by an existing module
+    size_t residentBytes;  //SPIR-V kept in memory
+};
+
+/*! @brief Reference counted shader modules of a device, keyed by a hash of their SPIR-V.
+ *
+ * Identical code acquired by several windows or pipeline rebuilds maps to one VkShaderModule. A module is
+ * destroyed when its last reference is released. With 'keepCode' the SPIR-V stays resident after that, so
+ * a module acquired again by name is recreated without reading the file. Code is reflected when its module is
+ * created, so pipelines can derive their layouts without parsing it again.
+ */
+class ShaderLibrary
+{
+public:
+
+    ShaderLibrary();
+    ~ShaderLibrary();
+
+    void create(VkDevice device, bool keepCode);
+
+    /*! @brief Destroys every module, references still held are reported.
+     *
+     */
+    void destroy();
+
+    /*! @brief Returns the module for 'code', creating it on first use, and adds a reference.
+     *
+     * @param[in] name Optional, lets later acquisitions by name skip loading the code
+     */
+    VkShaderModule acquire(const std::vector<char>& code, const std::string& name = "");
+
+    /*! @brief Returns the module last acquired under 'name' and adds a reference.
+     *
+     * @return VK_NULL_HANDLE if the module is neither alive nor resident, the code must then be loaded.
+     */
+    VkShaderModule acquire(const std::string& name);
+
+    /*! @brief Whether acquire(name) succeeds without the code.
+     *
+     */
+    bool isAvailable(const std::string& name);
+
+    void release(VkShaderModule module);
+
+    /*! @brief Returns the resident SPIR-V of a module, empty if it was not kept.
+     *
+     */
+    std::vector<char> getCode(VkShaderModule module);
+
+    /*! @brief Returns the interface of a module, reflected once when its code was first seen.
+     *
+     */
+    ShaderReflection getReflection(VkShaderModule module);
+
+    ShaderLibraryStats getStats();
+
+protected:
+
+
+
+private:
+
+    typedef std::pair<uint64_t, size_t> ShaderKey;
+
+    struct ShaderEntry
+    {
+        VkShaderModule module;
+        uint32_t refCount;
+        std::vector<char> code;
+        ShaderReflection reflection;
+    };
+
+    VkDevice device;
+    bool keepCode;
+
+    std::map<ShaderKey, ShaderEntry> entries;
+    std::map<std::string, ShaderKey> names;
+    std::map<VkShaderModule, ShaderKey> modules;
+
+    uint64_t createdCount;
+    uint64_t reusedCount;
+
+    std::mutex mutex;
+
+    static ShaderKey hashCode(const std::vector<char>& code);
+
+    VkShaderModule acquireEntry(const ShaderKey& key, ShaderEntry& entry, const std::vector<char>& code);
+};
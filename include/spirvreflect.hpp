@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vertexlayout.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*! @brief A stage input or output with an explicit location, built-ins are not listed.
+ *
+ */
+struct ShaderVariable
+{
+    uint32_t location;
+    ShaderInputType type;
+    uint32_t componentCount; //components per location, a matrix or array occupies several locations
+    std::string name;
+};
+
+struct ShaderBinding
+{
+    uint32_t set;
+    uint32_t binding;
+    VkDescriptorType descriptorType;
+    uint32_t descriptorCount; //runtime sized arrays are reported with a count of one
+    std::string name;
+};
+
+struct ShaderSpecConstant
+{
+    uint32_t constantId;
+    uint32_t size;
+    std::string name;
+};
+
+/*! @brief Interface of a shader module as read from its SPIR-V.
+ *
+ * Only the first entry point is reflected.
+ */
+struct ShaderReflection
+{
+    VkShaderStageFlagBits stage;
+    std::string entryPoint;
+
+    std::vector<ShaderVariable> inputs;
+    std::vector<ShaderVariable> outputs;
+    std::vector<ShaderBinding> bindings;
+
+    uint32_t pushConstantSize; //zero without a push constant block
+    std::vector<ShaderSpecConstant> specConstants;
+
+    uint32_t localSize[3]; //workgroup size of compute shaders
+};
+
+/*! @brief Parses a SPIR-V binary.
+ *
+ * Throws if 'code' is not a SPIR-V module or uses types reflection does not understand.
+ */
+ShaderReflection reflectShader(const std::vector<char>& code);
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <deque>
+#include <mutex>
+#include <vector>
+
+/*! @brief Range of the staging ring reserved for a single upload.
+ *
+ */
+struct StagingRegion
+{
+    VkBuffer buffer;
+    VkDeviceSize offset;
+    VkDeviceSize size;
+    void* pMapped;
+};
+
+struct StagingSubmission
+{
+    uint64_t serial;
+    VkDeviceSize begin;
+    VkDeviceSize end;
+    VkFence fence;
+    VkCommandPool pool;
+    VkCommandBuffer commandBuffer;
+    std::vector<VkSemaphore> semaphores;
+};
+
+/*! @brief Persistently mapped ring of host visible memory used as the source of uploads.
+ *
+ * Regions are handed out in order and stay reserved until the fence of the submission that consumed
+ * them signals. When the ring is full the oldest submission is waited on before space is reused.
+ * Every submission receives an increasing serial which doubles as the completion token of uploads.
+ *
+ * The ring only guards its own state. Command buffers are freed back to their pool whenever submissions are
+ * reclaimed, so the owner must serialise calls with every other use of those pools.
+ */
+class StagingRing
+{
+public:
+
+    StagingRing();
+    ~StagingRing();
+
+    /*! @brief Initialises the ring on top of a host visible buffer.
+     *
+     * @param[in] device Logical device owning the buffer
+     * @param[in] buffer Buffer created with VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+     * @param[in] pMapped Persistent mapping of the buffer
+     * @param[in] capacity Size of the buffer in bytes
+     */
+    void create(VkDevice device, VkBuffer buffer, void* pMapped, VkDeviceSize capacity);
+
+    /*! @brief Waits for all submissions and frees their command buffers and fences.
+     *
+     */
+    void destroy();
+
+    /*! @brief Reserves a region of the ring, waiting on older submissions if it is full.
+     *
+     * @param[in] size Size of the region in bytes
+     * @param[in] alignment Required alignment of the region offset
+     *
+     * @return Reserved region.
+     */
+    StagingRegion allocate(VkDeviceSize size, VkDeviceSize alignment);
+
+    /*! @brief Returns a reset fence for the next submission.
+     *
+     */
+    VkFence acquireFence();
+
+    /*! @brief Returns an unsignalled semaphore for cross queue hand-off.
+     *
+     */
+    VkSemaphore acquireSemaphore();
+
+    /*! @brief Ties all regions allocated since the last submission to a fence.
+     *
+     * The command buffer is freed back to its pool and the semaphores waited on by it recycled once the fence signals.
+     *
+     * @return Serial of the submission.
+     */
+    uint64_t submit(VkFence fence, VkCommandPool pool, VkCommandBuffer commandBuffer, const std::vector<VkSemaphore>& semaphores);
+
+    /*! @brief Returns the serial up to which all submissions have completed.
+     *
+     */
+    uint64_t getCompletedSerial();
+
+    /*! @brief Blocks until all submissions up to and including 'serial' have completed.
+     *
+     */
+    void waitForSerial(uint64_t serial);
+
+    /*! @brief Releases regions of every submission whose fence has signalled.
+     *
+     */
+    void reclaim();
+
+    VkDeviceSize getCapacity();
+
+protected:
+
+
+
+private:
+
+    VkDevice device;
+
+    VkBuffer buffer;
+    void* pMapped;
+    VkDeviceSize capacity;
+
+    VkDeviceSize head;
+    VkDeviceSize pendingBegin;
+    uint32_t pendingCount;
+
+    uint64_t submittedSerial;
+    uint64_t completedSerial;
+
+    std::deque<StagingSubmission> submissions;
+    std::vector<VkFence> freeFences;
+    std::vector<VkSemaphore> freeSemaphores;
+    std::vector<VkSemaphore> semaphores;
+
+    std::mutex mutex;
+
+    void reclaimSignalled();
+    void release(StagingSubmission& submission);
+};
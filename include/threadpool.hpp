@@ -0,0 +1,66 @@
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*! @brief Fixed set of worker threads executing indexed tasks.
+ *
+ * Every worker has a stable index in [0, getThreadCount()) which callers use to pick per-thread resources
+ * such as command pools.
+ */
+class ThreadPool
+{
+public:
+
+    ThreadPool();
+    ~ThreadPool();
+
+    /*! @brief Starts the worker threads.
+     *
+     * @param[in] threadCount Number of workers, at least one is started
+     */
+    void create(uint32_t threadCount);
+
+    /*! @brief Stops and joins all workers.
+     *
+     */
+    void destroy();
+
+    /*! @brief Runs 'task' once for every task index and blocks until all have finished.
+     *
+     * The first exception thrown by a task is rethrown once all tasks have finished.
+     *
+     * @param[in] taskCount Number of tasks
+     * @param[in] task Called with the task index and the index of the executing worker
+     */
+    void run(uint32_t taskCount, const std::function<void(uint32_t, uint32_t)>& task);
+
+    uint32_t getThreadCount();
+
+protected:
+
+
+
+private:
+
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::mutex runMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable workDone;
+
+    const std::function<void(uint32_t, uint32_t)>* pTask;
+    uint32_t taskCount;
+    uint32_t nextTask;
+    uint32_t completedTasks;
+    std::exception_ptr error;
+
+    bool stopping;
+
+    void work(uint32_t threadIndex);
+};
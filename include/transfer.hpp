@@ -0,0 +1,91 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+struct ImageCopyTarget
+{
+    VkBuffer srcBuffer;
+    VkImage dstImage;
+    VkImageLayout dstLayout;
+
+    bool operator<(const ImageCopyTarget& other) const;
+};
+
+struct ImageTransferTarget
+{
+    VkImage image;
+    VkImageLayout layout;
+    VkImageAspectFlags aspectMask;
+};
+
+/*! @brief Collects buffer and image copies so they can be submitted as one command buffer.
+ *
+ * Buffer copies between the same pair of buffers are sorted and adjacent regions merged before
+ * recording. Copies are recorded with one vkCmdCopyBuffer / vkCmdCopyBufferToImage per target.
+ */
+class TransferBatch
+{
+public:
+
+    TransferBatch();
+    ~TransferBatch();
+
+    /*! @brief Sets whether the batch is submitted on the dedicated transfer queue.
+     *
+     * Asynchronous batches hand their destinations to the graphics queue through Device::acquireUpload().
+     */
+    void setAsync(bool async);
+    bool isAsync();
+
+    void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize srcOffset, VkDeviceSize dstOffset, VkDeviceSize size);
+    void copyBufferToImage(VkBuffer srcBuffer, VkImage dstImage, VkImageLayout dstLayout, const VkBufferImageCopy& region);
+
+    /*! @brief Records all collected copies into a command buffer.
+     *
+     * @return Number of copy regions recorded after coalescing.
+     */
+    uint32_t record(VkCommandBuffer commandBuffer);
+
+    /*! @brief Returns every buffer written by the batch.
+     *
+     */
+    std::set<VkBuffer> getDstBuffers();
+
+    /*! @brief Returns every image written by the batch together with its layout and copied aspects.
+     *
+     */
+    std::vector<ImageTransferTarget> getDstImages();
+
+    VkDeviceSize getStagedBytes();
+    void addStagedBytes(VkDeviceSize size);
+
+    bool empty();
+    void clear();
+
+    /*! @brief Takes 'mutex' unless the batch already holds it, the lock is kept until unlock() or destruction.
+     *
+     */
+    void lock(std::recursive_mutex& mutex);
+    void unlock();
+
+protected:
+
+
+
+private:
+
+    bool async;
+    VkDeviceSize stagedBytes;
+
+    std::unique_lock<std::recursive_mutex> uploadLock;
+
+    std::map<std::pair<VkBuffer, VkBuffer>, std::vector<VkBufferCopy>> bufferCopies;
+    std::map<ImageCopyTarget, std::vector<VkBufferImageCopy>> imageCopies;
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <allocator.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+#include <string.h>
+
+class Device;
+
+/*! @brief Range of the uniform ring holding one or more uniform blocks.
+ *
+ * 'offset' is passed as the dynamic offset of a UNIFORM_BUFFER_DYNAMIC descriptor pointing at the start of the
+ * ring. Element 'i' of an array allocation lives at 'offset + i * stride', every element is aligned for binding.
+ */
+struct UniformAllocation
+{
+    uint32_t offset;
+    uint32_t stride;
+    void* pMapped;
+};
+
+/*! @brief Persistently mapped uniform buffer split into one region per frame in flight.
+ *
+ * Each frame bump allocates from its own region, which is rewound by beginFrame once the frame's fence has
+ * signalled. Nothing is freed individually, so thousands of per-draw blocks cost one pointer increment each.
+ * Allocations are made by the thread recording the frame, workers write through array allocations handed to them.
+ */
+class UniformRing
+{
+public:
+
+    UniformRing();
+    ~UniformRing();
+
+    /*! @brief Creates the ring buffer.
+     *
+     * @param[in] device Device the buffer is created on
+     * @param[in] frameCount Number of frames in flight
+     * @param[in] frameCapacity Bytes available to a single frame
+     */
+    void create(Device& device, uint32_t frameCount, VkDeviceSize frameCapacity);
+    void destroy(Device& device);
+
+    /*! @brief Rewinds the region of 'frame', its previous submission must have completed.
+     *
+     */
+    void beginFrame(uint32_t frame);
+
+    /*! @brief Reserves 'size' bytes in the region of the current frame.
+     *
+     * Throws if the region is full.
+     */
+    UniformAllocation allocate(VkDeviceSize size);
+
+    /*! @brief Reserves 'count' blocks of 'size' bytes, each aligned to be bound with its own dynamic offset.
+     *
+     */
+    UniformAllocation allocateArray(VkDeviceSize size, uint32_t count);
+
+    /*! @brief Copies 'data' into the ring and returns its dynamic offset.
+     *
+     */
+    template <typename T>
+    uint32_t push(const T& data);
+
+    /*! @brief Bytes a block of 'size' bytes occupies in the ring, the stride of array allocations.
+     *
+     */
+    VkDeviceSize getStride(VkDeviceSize size);
+
+    /*! @brief Buffer to point UNIFORM_BUFFER_DYNAMIC descriptors at, with offset zero.
+     *
+     */
+    VkBuffer getBuffer();
+
+    /*! @brief Bytes allocated by the current frame so far.
+     *
+     */
+    VkDeviceSize getFrameUsage();
+
+    VkDeviceSize getFrameCapacity();
+
+protected:
+
+
+
+private:
+
+    VkBuffer buffer;
+    Allocation allocation;
+
+    VkDeviceSize alignment;
+    VkDeviceSize frameCapacity;
+
+    VkDeviceSize frameBegin;
+    VkDeviceSize head;
+};
+
+template <typename T>
+uint32_t UniformRing::push(const T& data)
+{
+    UniformAllocation uniforms = allocate(sizeof(T));
+    memcpy(uniforms.pMapped, &data, sizeof(T));
+    return uniforms.offset;
+}
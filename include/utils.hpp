@@ -3,6 +3,6 @@
 #include <device.hpp>
 
 void here();
-VkInstance getInstance();
-
-std::vector<char> readFile(const std::string& fileName);
\ No newline at end of file
+void createInstance(bool headless = false);
+void destroyInstance();
+VkInstance getInstance();
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <glm/glm.hpp>
+
+#include <vertexlayout.hpp>
+
+#include <cstddef>
+
+struct Vertex
+{
+    glm::vec2 pos;
+    glm::vec3 color;
+
+    bool operator==(const Vertex& other) const;
+};
+
+inline constexpr auto VERTEX_STREAM = makeVertexStream<Vertex>(VK_VERTEX_INPUT_RATE_VERTEX,
+    VERTEX_ATTRIBUTE(Vertex, pos), VERTEX_ATTRIBUTE(Vertex, color));
+
+/*! @brief Hash over the bit patterns of all vertex attributes, consistent with Vertex::operator==.
+ *
+ */
+struct VertexHash
+{
+    size_t operator()(const Vertex& vertex) const;
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vertex.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*! @brief Memory layouts vertices can be uploaded in.
+ *
+ * All layouts feed the same shader inputs, the attribute formats expand them back to floats on fetch.
+ */
+enum VertexFormat
+{
+    VERTEX_FORMAT_FLOAT,  //R32G32_SFLOAT position, R32G32B32_SFLOAT color, 20 bytes
+    VERTEX_FORMAT_HALF,   //R16G16_SFLOAT position, R8G8B8A8_UNORM color, 8 bytes
+    VERTEX_FORMAT_SNORM16 //R16G16_SNORM position, R8G8B8A8_UNORM color, 8 bytes, positions must lie in [-1, 1]
+};
+
+struct VertexHalf
+{
+    uint16_t pos[2];
+    uint8_t color[4];
+};
+
+struct VertexSnorm16
+{
+    int16_t pos[2];
+    uint8_t color[4];
+};
+
+inline constexpr auto VERTEX_HALF_STREAM = makeVertexStream<VertexHalf>(VK_VERTEX_INPUT_RATE_VERTEX,
+    VERTEX_ATTRIBUTE_FORMAT(VertexHalf, pos, VK_FORMAT_R16G16_SFLOAT), VERTEX_ATTRIBUTE_FORMAT(VertexHalf, color, VK_FORMAT_R8G8B8A8_UNORM));
+
+inline constexpr auto VERTEX_SNORM16_STREAM = makeVertexStream<VertexSnorm16>(VK_VERTEX_INPUT_RATE_VERTEX,
+    VERTEX_ATTRIBUTE_FORMAT(VertexSnorm16, pos, VK_FORMAT_R16G16_SNORM), VERTEX_ATTRIBUTE_FORMAT(VertexSnorm16, color, VK_FORMAT_R8G8B8A8_UNORM));
+
+uint32_t getVertexStride(VertexFormat format);
+
+/*! @brief Encodes one float as IEEE half, rounding to nearest even.
+ *
+ */
+uint16_t encodeHalf(float value);
+
+/*! @brief Encodes one float as signed normalised 16 bit, clamped to [-1, 1].
+ *
+ */
+int16_t encodeSnorm16(float value);
+
+/*! @brief Encodes one float as unsigned normalised 8 bit, clamped to [0, 1].
+ *
+ */
+uint8_t encodeUnorm8(float value);
+
+/*! @brief Bulk conversions of float arrays, vectorised with F16C/SSE2 or NEON where the target supports it.
+ *
+ * Results are identical to the scalar encoders.
+ */
+void encodeHalf(const float* pSrc, uint16_t* pDst, size_t count);
+void encodeSnorm16(const float* pSrc, int16_t* pDst, size_t count);
+void encodeUnorm8(const float* pSrc, uint8_t* pDst, size_t count);
+
+/*! @brief Converts vertices to the interleaved layout of 'format'.
+ *
+ * Colors are written with an alpha of one.
+ *
+ * @return Vertex data ready to be copied into a vertex buffer.
+ */
+std::vector<uint8_t> packVertices(const std::vector<Vertex>& vertices, VertexFormat format);
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+/*! @brief Compile time description of vertex input layouts.
+ *
+ * A vertex type lists its members once as a stream, bindings, locations and offsets are derived from it:
+ *
+ *     constexpr auto VERTEX_STREAM = makeVertexStream<Vertex>(VK_VERTEX_INPUT_RATE_VERTEX,
+ *         VERTEX_ATTRIBUTE(Vertex, pos), VERTEX_ATTRIBUTE(Vertex, color));
+ *
+ *     constexpr auto LAYOUT = makeVertexLayout(VERTEX_STREAM, INSTANCE_STREAM);
+ *
+ * Each stream of a layout becomes one binding, numbered in order. Locations are assigned in order over all
+ * attributes of all streams, so split streams (e.g. positions alone in binding 0 for a depth pass, the remaining
+ * attributes in binding 1) keep the locations of the interleaved layout. Layouts can be checked against the
+ * inputs a shader declares with matchesShaderInputs in a static_assert, or at runtime against its reflected inputs.
+ */
+
+enum ShaderInputType
+{
+    SHADER_INPUT_FLOAT, //float, vecN, fed by SFLOAT, UNORM and SNORM formats
+    SHADER_INPUT_INT,   //int, ivecN, fed by SINT formats
+    SHADER_INPUT_UINT   //uint, uvecN, fed by UINT formats
+};
+
+struct ShaderInput
+{
+    uint32_t location;
+    ShaderInputType type;
+};
+
+struct VertexAttribute
+{
+    VkFormat format;
+    uint32_t offset;
+};
+
+template <size_t AttributeCount>
+struct VertexStream
+{
+    uint32_t stride;
+    VkVertexInputRate inputRate;
+    std::array<VertexAttribute, AttributeCount> attributes;
+};
+
+template <size_t BindingCount, size_t AttributeCount>
+struct VertexLayout
+{
+    std::array<VkVertexInputBindingDescription, BindingCount> bindings;
+    std::array<VkVertexInputAttributeDescription, AttributeCount> attributes;
+};
+
+/*! @brief Default format of a member type, members without one need VERTEX_ATTRIBUTE_FORMAT.
+ *
+ */
+template <typename T>
+struct VertexAttributeFormat;
+
+template <> struct VertexAttributeFormat<float> { static constexpr VkFormat format = VK_FORMAT_R32_SFLOAT; };
+template <> struct VertexAttributeFormat<glm::vec2> { static constexpr VkFormat format = VK_FORMAT_R32G32_SFLOAT; };
+template <> struct VertexAttributeFormat<glm::vec3> { static constexpr VkFormat format = VK_FORMAT_R32G32B32_SFLOAT; };
+template <> struct VertexAttributeFormat<glm::vec4> { static constexpr VkFormat format = VK_FORMAT_R32G32B32A32_SFLOAT; };
+template <> struct VertexAttributeFormat<int32_t> { static constexpr VkFormat format = VK_FORMAT_R32_SINT; };
+template <> struct VertexAttributeFormat<glm::ivec2> { static constexpr VkFormat format = VK_FORMAT_R32G32_SINT; };
+template <> struct VertexAttributeFormat<glm::ivec3> { static constexpr VkFormat format = VK_FORMAT_R32G32B32_SINT; };
+template <> struct VertexAttributeFormat<glm::ivec4> { static constexpr VkFormat format = VK_FORMAT_R32G32B32A32_SINT; };
+template <> struct VertexAttributeFormat<uint32_t> { static constexpr VkFormat format = VK_FORMAT_R32_UINT; };
+template <> struct VertexAttributeFormat<glm::uvec2> { static constexpr VkFormat format = VK_FORMAT_R32G32_UINT; };
+template <> struct VertexAttributeFormat<glm::uvec3> { static constexpr VkFormat format = VK_FORMAT_R32G32B32_UINT; };
+template <> struct VertexAttributeFormat<glm::uvec4> { static constexpr VkFormat format = VK_FORMAT_R32G32B32A32_UINT; };
+
+constexpr uint32_t getVertexFormatSize(VkFormat format)
+{
+    switch (format)
+    {
+        case VK_FORMAT_R8G8_UNORM: case VK_FORMAT_R8G8_SNORM: case VK_FORMAT_R8G8_UINT: case VK_FORMAT_R8G8_SINT:
+            return 2;
+        case VK_FORMAT_R8G8B8A8_UNORM: case VK_FORMAT_R8G8B8A8_SNORM: case VK_FORMAT_R8G8B8A8_UINT: case VK_FORMAT_R8G8B8A8_SINT:
+        case VK_FORMAT_R16G16_SFLOAT: case VK_FORMAT_R16G16_UNORM: case VK_FORMAT_R16G16_SNORM: case VK_FORMAT_R16G16_UINT: case VK_FORMAT_R16G16_SINT:
+        case VK_FORMAT_R32_SFLOAT: case VK_FORMAT_R32_UINT: case VK_FORMAT_R32_SINT:
+            return 4;
+        case VK_FORMAT_R16G16B16A16_SFLOAT: case VK_FORMAT_R16G16B16A16_UNORM: case VK_FORMAT_R16G16B16A16_SNORM:
+        case VK_FORMAT_R16G16B16A16_UINT: case VK_FORMAT_R16G16B16A16_SINT:
+        case VK_FORMAT_R32G32_SFLOAT: case VK_FORMAT_R32G32_UINT: case VK_FORMAT_R32G32_SINT:
+            return 8;
+        case VK_FORMAT_R32G32B32_SFLOAT: case VK_FORMAT_R32G32B32_UINT: case VK_FORMAT_R32G32B32_SINT:
+            return 12;
+        case VK_FORMAT_R32G32B32A32_SFLOAT: case VK_FORMAT_R32G32B32A32_UINT: case VK_FORMAT_R32G32B32A32_SINT:
+            return 16;
+        default:
+            throw std::runtime_error("Error! Unsupported vertex attribute format!");
+    }
+}
+
+constexpr ShaderInputType getVertexFormatInputType(VkFormat format)
+{
+    switch (format)
+    {
+        case VK_FORMAT_R8G8_UINT: case VK_FORMAT_R8G8B8A8_UINT: case VK_FORMAT_R16G16_UINT: case VK_FORMAT_R16G16B16A16_UINT:
+        case VK_FORMAT_R32_UINT: case VK_FORMAT_R32G32_UINT: case VK_FORMAT_R32G32B32_UINT: case VK_FORMAT_R32G32B32A32_UINT:
+            return SHADER_INPUT_UINT;
+        case VK_FORMAT_R8G8_SINT: case VK_FORMAT_R8G8B8A8_SINT: case VK_FORMAT_R16G16_SINT: case VK_FORMAT_R16G16B16A16_SINT:
+        case VK_FORMAT_R32_SINT: case VK_FORMAT_R32G32_SINT: case VK_FORMAT_R32G32B32_SINT: case VK_FORMAT_R32G32B32A32_SINT:
+            return SHADER_INPUT_INT;
+        default:
+            return SHADER_INPUT_FLOAT;
+    }
+}
+
+/*! @brief Checks that the format does not read past the member it describes.
+ *
+ * Evaluated at compile time through the VERTEX_ATTRIBUTE macros, a mismatch fails the build.
+ */
+constexpr VertexAttribute makeVertexAttribute(VkFormat format, size_t offset, size_t memberSize)
+{
+    if (getVertexFormatSize(format) > memberSize)
+    {
+        throw std::runtime_error("Error! Vertex attribute format is larger than its member!");
+    }
+
+    return VertexAttribute{format, static_cast<uint32_t>(offset)};
+}
+
+#define VERTEX_ATTRIBUTE(type, member) \
+    makeVertexAttribute(VertexAttributeFormat<decltype(type::member)>::format, offsetof(type, member), sizeof(type::member))
+
+#define VERTEX_ATTRIBUTE_FORMAT(type, member, format) \
+    makeVertexAttribute(format, offsetof(type, member), sizeof(type::member))
+
+/*! @brief Describes one binding holding elements of type T.
+ *
+ * The attributes may cover only some members of T, e.g. the positions of an interleaved vertex for a depth pass.
+ */
+template <typename T, typename... Attributes>
+constexpr VertexStream<sizeof...(Attributes)> makeVertexStream(VkVertexInputRate inputRate, Attributes... attributes)
+{
+    return VertexStream<sizeof...(Attributes)>{static_cast<uint32_t>(sizeof(T)), inputRate, {{attributes...}}};
+}
+
+template <size_t BindingCount, size_t AttributeCount, size_t StreamAttributeCount>
+constexpr void appendVertexStream(VertexLayout<BindingCount, AttributeCount>& layout, uint32_t& binding, uint32_t& location,
+    const VertexStream<StreamAttributeCount>& stream)
+{
+    layout.bindings[binding].binding = binding;
+    layout.bindings[binding].stride = stream.stride;
+    layout.bindings[binding].inputRate = stream.inputRate;
+
+    for (size_t i = 0; i < StreamAttributeCount; i++)
+    {
+        layout.attributes[location].binding = binding;
+        layout.attributes[location].location = location;
+        layout.attributes[location].format = stream.attributes[i].format;
+        layout.attributes[location].offset = stream.attributes[i].offset;
+        location++;
+    }
+
+    binding++;
+}
+
+template <size_t... StreamAttributeCounts>
+constexpr VertexLayout<sizeof...(StreamAttributeCounts), (StreamAttributeCounts + ... + 0)> makeVertexLayout(
+    const VertexStream<StreamAttributeCounts>&... streams)
+{
+    VertexLayout<sizeof...(StreamAttributeCounts), (StreamAttributeCounts + ... + 0)> layout = {};
+
+    uint32_t binding = 0;
+    uint32_t location = 0;
+    (appendVertexStream(layout, binding, location, streams), ...);
+
+    return layout;
+}
+
+/*! @brief Checks that every shader input is fed by an attribute of a compatible numeric type.
+ *
+ * Attributes without a matching shader input are allowed, the shader ignores them. 'inputs' is any range of
+ * elements with 'location' and 'type', a std::array of ShaderInput at compile time or reflected inputs at runtime.
+ */
+template <size_t BindingCount, size_t AttributeCount, typename InputContainer>
+constexpr bool matchesShaderInputs(const VertexLayout<BindingCount, AttributeCount>& layout, const InputContainer& inputs)
+{
+    for (const auto& input : inputs)
+    {
+        bool found = false;
+        for (size_t j = 0; j < AttributeCount; j++)
+        {
+            if (layout.attributes[j].location == input.location)
+            {
+                if (getVertexFormatInputType(layout.attributes[j].format) != input.type)
+                {
+                    return false;
+                }
+                found = true;
+            }
+        }
+
+        if (!found)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -5,9 +5,23 @@
 
 #include <glm/glm.hpp>
 
+#include <array>
+#include <memory>
+#include <string>
 #include <vector>
 
+#include <assetloader.hpp>
+#include <cullpass.hpp>
 #include <device.hpp>
+#include <deviceregistry.hpp>
+#include <drawlist.hpp>
+#include <frame.hpp>
+#include <geometrycache.hpp>
+#include <meshfile.hpp>
+#include <threadpool.hpp>
+#include <uniformring.hpp>
+#include <vertex.hpp>
+#include <vertexformat.hpp>
 
 struct Swapchain
 {
@@ -20,25 +34,125 @@ struct Swapchain
     std::vector<VkFramebuffer> framebuffers;
 };
 
+/*! @brief Swapchain replaced by a recreate, destroyed once presents to it can no longer be pending.
+ *
+ */
+struct RetiredSwapchain
+{
+    Swapchain swapchain;
+    std::vector<Allocation> allocations;
+    std::vector<VkSemaphore> renderFinishedSemaphores; //waited on by presents to the old images
+    uint64_t destroyFrame;
+};
+
 struct GraphicsPipeline
 {
     VkRenderPass renderPass;
     VkPipelineLayout layout;
     VkPipeline pipeline;
 
+    std::vector<VkDescriptorSetLayout> setLayouts; //owned by the device layout cache, like 'layout'
     std::vector<VkShaderModule> shaderModules;
 };
 
-struct Vertex
+/*! @brief Per-instance vertex stream, read once per drawn copy of the mesh.
+ *
+ */
+struct InstanceData
 {
-    glm::vec2 pos;
+    glm::vec4 transform; //xy offset, zw scale
     glm::vec3 color;
+};
+
+/*! @brief Uniform block of vertex.vert, written to the uniform ring once per frame.
+ *
+ */
+struct FrameUniforms
+{
+    glm::vec4 viewTransform; //xy offset, zw scale
+};
 
-    static VkVertexInputBindingDescription getBindingDescription();
-    static std::array<VkVertexInputAttributeDescription, 2> getAttributeDescriptions();
-    bool operator==(const Vertex& other) const;
+/*! @brief Per-draw uniform block of vertex.vert, one per draw call in DRAW_MODE_DIRECT.
+ *
+ * Direct draws read their instance from here instead of the instance stream. Other modes bind a single block
+ * with 'instanced' set, so the stream is used.
+ */
+struct DrawUniforms
+{
+    glm::vec4 transform; //xy offset, zw scale
+    glm::vec4 color;     //xyz used
+    uint32_t instanced;  //non-zero reads the instance stream instead
+    uint32_t padding[3];
 };
 
+inline constexpr auto INSTANCE_STREAM = makeVertexStream<InstanceData>(VK_VERTEX_INPUT_RATE_INSTANCE,
+    VERTEX_ATTRIBUTE(InstanceData, transform), VERTEX_ATTRIBUTE(InstanceData, color));
+
+struct InstanceBuffer
+{
+    VkBuffer buffer;
+    Allocation allocation;
+    VkDeviceSize capacity;
+};
+
+/*! @brief How the instances of a window are turned into draw calls.
+ *
+ */
+enum DrawMode
+{
+    DRAW_MODE_DIRECT,    //one vkCmdDrawIndexed per instance
+    DRAW_MODE_INSTANCED, //one instanced vkCmdDrawIndexed per recording thread
+    DRAW_MODE_INDIRECT   //one indirect draw per instance, submitted from a DrawList in a single call
+};
+
+/*! @brief Trade-off between input latency, throughput and power used when presenting.
+ *
+ */
+enum PresentPolicy
+{
+    PRESENT_POLICY_BALANCED,
+    PRESENT_POLICY_LOW_LATENCY,
+    PRESENT_POLICY_THROUGHPUT,
+    PRESENT_POLICY_POWER_SAVE
+};
+
+/*! @brief Frames in flight, swapchain image count and present modes selected by a present policy.
+ *
+ * 'extraImages' is added to the surface's minimum image count, 'presentModes' lists modes in order of
+ * preference, FIFO is used if none is supported.
+ */
+struct PresentConfig
+{
+    uint32_t framesInFlight;
+    uint32_t extraImages;
+    std::vector<VkPresentModeKHR> presentModes;
+};
+
+PresentConfig getPresentConfig(PresentPolicy policy);
+
+/*! @brief Frame submitted by Window::renderFrame, waiting to be presented.
+ *
+ * 'rendered' is false if nothing was submitted, e.g. while minimised, finishFrame must then not be called.
+ * Headless frames are rendered but not presented.
+ */
+struct FramePresent
+{
+    bool rendered;
+    bool present;
+
+    Device* device;
+    VkQueue queue;
+    VkSwapchainKHR swapchain;
+    uint32_t imageIndex;
+    VkSemaphore waitSemaphore;
+};
+
+/*! @brief Presents frames of several windows with one vkQueuePresentKHR per queue.
+ *
+ * @return Result of every frame, VK_SUCCESS for frames that are not presented.
+ */
+std::vector<VkResult> presentFrames(const std::vector<FramePresent>& frames);
+
 class Window
 {
 public:
@@ -85,6 +199,101 @@ public:
      */
     void setTitle(char* title);
 
+    /*! @brief Selects headless rendering, must be called before the window is launched.
+     *
+     * Headless windows render into device owned images instead of a swapchain and need neither GLFW
+     * nor a display, so they can run on display-less hosts and software implementations such as lavapipe.
+     *
+     * @param[in] headless 'true' to render offscreen
+     */
+    void setHeadless(bool headless);
+    bool isHeadless();
+
+    /*! @brief Sets the number of frames after which a headless window should close.
+     *
+     * @param[in] frameLimit Number of frames, 0 renders until the application stops
+     */
+    void setFrameLimit(uint32_t frameLimit);
+
+    /*! @brief Selects how frames are queued and presented.
+     *
+     * Changing the policy of a launched window waits for the device to idle, then rebuilds the swapchain,
+     * command pools and sync objects.
+     *
+     * @param[in] policy New present policy
+     */
+    void setPresentPolicy(PresentPolicy policy);
+    PresentPolicy getPresentPolicy();
+
+    /*! @brief Sets the copies of the mesh drawn each frame.
+     *
+     * Instances are written to a host visible buffer of the frame being recorded, so they can change every frame.
+     *
+     * @param[in] instances Transform and color of each copy
+     */
+    void setInstances(const std::vector<InstanceData>& instances);
+
+    /*! @brief Selects how instances are drawn.
+     *
+     * Indirect drawing falls back to instanced drawing if the device cannot draw indirect with a first instance.
+     *
+     * @param[in] drawMode New draw mode, takes effect with the next recorded frame
+     */
+    void setDrawMode(DrawMode drawMode);
+    DrawMode getDrawMode();
+
+    /*! @brief Sets the number of threads recording the window's draws, must be called before launch.
+     *
+     * Zero, the default, uses every core but the calling one.
+     */
+    void setRecordThreadCount(uint32_t threadCount);
+    uint32_t getRecordThreadCount();
+
+    /*! @brief Selects the memory layout of the window's vertex buffer, must be called before launch.
+     *
+     */
+    void setVertexFormat(VertexFormat vertexFormat);
+
+    /*! @brief Draws the mesh of a binary mesh file instead of the built-in quad, must be called before launch.
+     *
+     * Only the header is read here. The file is read by the asset loader while the window and device are created
+     * at launch, its streams are staged from the loaded contents. The vertex format becomes the one stored in the file.
+     */
+    void setMesh(const std::string& path);
+
+    /*! @brief Enables frustum culling on the compute queue for indirect drawing.
+     *
+     * Each frame a compute shader tests every instance against the cull planes and writes the surviving draws
+     * to the frame's draw list. The graphics submission waits on the culling submission through a semaphore.
+     * Ignored in other draw modes or on devices without a compute queue.
+     */
+    void setGpuCulling(bool gpuCulling);
+
+    /*! @brief Sets the planes instances are culled against, each as normal and distance with the inside positive.
+     *
+     * Planes are given in clip space, instances are tested after the view transform has been applied.
+     */
+    void setCullPlanes(const std::array<glm::vec4, 6>& planes);
+
+    /*! @brief Sets the region of the framebuffer rendered to, in fractions of the swapchain extent.
+     *
+     * Viewport and scissor are dynamic state, so changing them never recompiles the pipeline.
+     */
+    void setViewport(float x, float y, float width, float height);
+
+    /*! @brief Scales and offsets every instance after its own transform, without touching the instance data.
+     *
+     * Cull planes are not transformed, they stay in the space of the instance transforms.
+     */
+    void setViewTransform(const glm::vec2& offset, const glm::vec2& scale);
+
+    /*! @brief Sets cull mode, front face and primitive topology.
+     *
+     * Set at record time with VK_EXT_extended_dynamic_state, otherwise the pipeline is rebuilt. Switching
+     * between point, line, triangle and patch topologies always rebuilds it.
+     */
+    void setRasterState(VkCullModeFlags cullMode, VkFrontFace frontFace, VkPrimitiveTopology topology);
+
     /*! @brief Shows the window.
      *
      */ 
@@ -95,10 +304,36 @@ public:
      */ 
     void hide();
 
-    void launch(std::vector<Device>& devices);
+    /*! @brief Creates the window and everything it renders with.
+     *
+     * The device is taken from 'registry', an existing device is reused if it can present to the window's surface.
+     * Shaders and the mesh are read through 'assetLoader', which must outlive the window.
+     */
+    void launch(DeviceRegistry& registry, AssetLoader& assetLoader);
 
+    /*! @brief Renders and presents one frame, equivalent to prepareFrame, renderFrame, presentFrames and finishFrame.
+     *
+     * Also runs finished asset callbacks, for windows driven without an application.
+     */
     void drawFrame();
 
+    /*! @brief Polls window state, must be called on the main thread.
+     *
+     */
+    void prepareFrame();
+
+    /*! @brief Records and submits a frame without presenting it.
+     *
+     * May run on any thread, windows sharing a device may render concurrently. Submissions are serialised
+     * per queue by the device.
+     */
+    FramePresent renderFrame();
+
+    /*! @brief Advances to the next frame after the result of its present is known, recreating the swapchain if needed.
+     *
+     */
+    void finishFrame(VkResult presentResult);
+
     /*! @brief Destroys the window.
      *
      */
@@ -112,26 +347,59 @@ public:
 
     VkSurfaceKHR getSurface();
 
+    /*! @brief Returns the GPU profiler timing the window's frames, valid after launch().
+     *
+     */
+    GpuProfiler* getProfiler();
+
+    /*! @brief Loader shared by every window of the application, its completion callbacks run on the main thread.
+     *
+     * Only valid between launch and destroy.
+     */
+    AssetLoader* getAssetLoader();
+
+    /*! @brief Sets a file the GPU timings are written to when the window is destroyed.
+     *
+     * @param[in] path JSON file if it ends in ".json", otherwise CSV, empty disables the dump
+     */
+    void setProfileOutput(const std::string& path);
+
+    /*! @brief Reads back the most recently rendered frame of a headless window.
+     *
+     * @returns Tightly packed R8G8B8A8 pixels, row by row.
+     */
+    std::vector<uint8_t> readPixels();
+
 protected:
 
 
 private:
 
-    Device device;
+    Device* device;
 
     GLFWwindow* window;
     VkSurfaceKHR surface;
 
     Swapchain swapchain;
     GraphicsPipeline pipeline;
-    std::vector<VkCommandBuffer> commandBuffers;
+    std::vector<FrameContext> frameContexts;
+    ThreadPool* threadPool;
+    uint32_t recordThreadCount;
+    AssetLoader* assetLoader;
+    AssetHandle<std::vector<char>> vertShaderAsset;
+    AssetHandle<std::vector<char>> fragShaderAsset;
+    AssetHandle<std::vector<char>> cullShaderAsset;
+    AssetHandle<std::shared_ptr<MeshFile>> meshAsset;
+    VkShaderModule vertShaderModule;
+    VkShaderModule fragShaderModule;
+    VkShaderModule cullShaderModule;
     std::vector<VkSemaphore> imageAvailableSemaphores;
     std::vector<VkSemaphore> renderFinishedSemaphores;
     std::vector<VkFence> inFlightFences;
     std::vector<VkFence> imagesInFlight;
 
-    VkBuffer vertexBuffer, indexBuffer;
-    VkDeviceMemory vertexBufferMemory, indexBufferMemory;
+    VkBuffer vertexBuffer, indexBuffer; //owned by the geometry cache of the device
+    UploadToken geometryUpload;
 
     int width, height;
     char* title;
@@ -139,17 +407,77 @@ private:
     bool launched;
     bool shown;
 
+    bool headless;
+    uint32_t frameLimit;
+    uint64_t frameCount;
+    uint32_t lastImageIndex;
+    int framebufferWidth, framebufferHeight;
+    bool recreatePending;
+    std::vector<Allocation> offscreenAllocations;
+    std::vector<RetiredSwapchain> retiredSwapchains;
+
+    GpuProfiler* profiler;
+    std::string profileOutput;
+
     size_t currentFrame;
 
-    void createSwapchain();
+    PresentPolicy presentPolicy;
+    uint32_t framesInFlight;
+
+    std::vector<InstanceData> instances;
+    std::vector<InstanceBuffer> instanceBuffers;
+    VertexFormat vertexFormat;
+    std::string meshPath;
+    uint32_t indexCount;
+    VkIndexType indexType;
+
+    std::vector<DrawList> drawLists;
+    DrawMode drawMode;
+
+    CullPass cullPass;
+    std::vector<FrameContext> computeContexts;
+    std::vector<VkSemaphore> cullFinishedSemaphores;
+    std::array<glm::vec4, 6> cullPlanes;
+    float meshRadius;
+    bool gpuCulling;
+    bool cullPassCreated;
+
+    std::array<float, 4> viewportRect;
+    FrameUniforms frameUniforms;
+    UniformRing uniformRing;
+    VkCullModeFlags cullMode;
+    VkFrontFace frontFace;
+    VkPrimitiveTopology topology;
+
+    void createSwapchain(VkSwapchainKHR oldSwapchain);
+    void createOffscreenImages();
     void createRenderPass();
     void createGraphicsPipeline();
     void createFramebuffers();
-    void createVertexBuffer();
-    void createIndexBuffer();
-    void createCommandBuffers();
+    void createGeometryBuffers();
+    GeometryBuffers uploadGeometry();
+    void createFrameContexts();
+    void updateInstanceBuffer();
+    bool isGpuCullingActive();
+    void submitCulling();
+    VkCommandBuffer recordCommandBuffer(uint32_t imageIndex, bool culling);
     void createSyncObjects();
     void destroySwapchain();
+    void destroySwapchainImages(Swapchain& target, std::vector<Allocation>& allocations);
+
+    /*! @brief Replaces the swapchain after a resize or an out of date surface.
+     *
+     * Waits only on the frames in flight and rebuilds image views and framebuffers. The render pass is
+     * only rebuilt if the surface format changed.
+     */
+    void recreateSwapchain();
+
+    /*! @brief Destroys retired swapchains whose frame has been reached, or all of them if the device is idle.
+     *
+     */
+    void destroyRetiredSwapchains(bool idle);
+    void destroySyncObjects();
+    void destroyFrameContexts();
 
-    VkShaderModule createShaderModule(const std::vector<char>& code);
+    VkShaderModule acquireShaderModule(const std::string& path, AssetHandle<std::vector<char>>& asset);
 };
\ No newline at end of file
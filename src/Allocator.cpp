@@ -0,0 +1,463 @@
+#include <allocator.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+const VkDeviceSize MIN_ALLOCATION_SIZE = 256;
+const VkDeviceSize DEFAULT_BLOCK_SIZE = 64 * 1024 * 1024;
+
+//fraction of a heap assumed to be available when VK_EXT_memory_budget is missing
+const VkDeviceSize ESTIMATED_BUDGET_PERCENT = 80;
+
+uint32_t countBits(uint32_t value)
+{
+    uint32_t count = 0;
+    while (value != 0)
+    {
+        value &= value - 1;
+        count++;
+    }
+    return count;
+}
+
+VkDeviceSize roundUpPowerOfTwo(VkDeviceSize value)
+{
+    VkDeviceSize result = 1;
+    while (result < value)
+    {
+        result <<= 1;
+    }
+    return result;
+}
+
+VkDeviceSize roundDownPowerOfTwo(VkDeviceSize value)
+{
+    VkDeviceSize result = 1;
+    while ((result << 1) <= value)
+    {
+        result <<= 1;
+    }
+    return result;
+}
+
+uint32_t orderForSize(VkDeviceSize size)
+{
+    uint32_t order = 0;
+    while ((MIN_ALLOCATION_SIZE << order) < size)
+    {
+        order++;
+    }
+    return order;
+}
+
+Allocator::Allocator()
+{
+
+}
+
+Allocator::~Allocator()
+{
+
+}
+
+void Allocator::create(VkPhysicalDevice physicalDevice, VkDevice device, bool memoryBudgetSupported)
+{
+    this->physicalDevice = physicalDevice;
+    this->device = device;
+    this->memoryBudgetSupported = memoryBudgetSupported;
+
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    bufferImageGranularity = properties.limits.bufferImageGranularity;
+
+    //small heaps (e.g. host visible device local windows) get proportionally smaller blocks
+    blockSizes.resize(memoryProperties.memoryTypeCount);
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+    {
+        VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[i].heapIndex].size;
+
+        VkDeviceSize blockSize = DEFAULT_BLOCK_SIZE;
+        if (heapSize / 8 < blockSize)
+        {
+            blockSize = std::max(roundDownPowerOfTwo(heapSize / 8), MIN_ALLOCATION_SIZE);
+        }
+
+        blockSizes[i] = blockSize;
+    }
+}
+
+void Allocator::destroy()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (uint32_t i = 0; i < blocks.size(); i++)
+    {
+        destroyBlock(i);
+    }
+
+    blocks.clear();
+}
+
+Allocation Allocator::allocate(const VkMemoryRequirements& requirements, uint32_t memoryTypeIndex, bool linear)
+{
+    VkDeviceSize size = requirements.size;
+    VkDeviceSize alignment = requirements.alignment;
+
+    //optimal resources own whole granularity pages so they never alias a linear resource
+    if (!linear)
+    {
+        alignment = std::max(alignment, bufferImageGranularity);
+        size = (size + bufferImageGranularity - 1) & ~(bufferImageGranularity - 1);
+    }
+
+    uint32_t order = orderForSize(std::max(size, roundUpPowerOfTwo(alignment)));
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    Allocation allocation = {};
+
+    if ((MIN_ALLOCATION_SIZE << order) > blockSizes[memoryTypeIndex] / 2)
+    {
+        uint32_t blockIndex = createBlock(memoryTypeIndex, requirements.size, true);
+
+        MemoryBlock& block = blocks[blockIndex];
+        block.usedBytes = block.size;
+
+        allocation.block = blockIndex;
+        allocation.memory = block.memory;
+        allocation.offset = 0;
+        allocation.size = requirements.size;
+        allocation.pMapped = block.pMapped;
+
+        return allocation;
+    }
+
+    VkDeviceSize offset = 0;
+    uint32_t blockIndex = UINT32_MAX;
+    for (uint32_t i = 0; i < blocks.size(); i++)
+    {
+        if (blocks[i].memory == VK_NULL_HANDLE || blocks[i].dedicated || blocks[i].memoryTypeIndex != memoryTypeIndex)
+        {
+            continue;
+        }
+
+        if (allocateFromBlock(blocks[i], order, offset))
+        {
+            blockIndex = i;
+            break;
+        }
+    }
+
+    if (blockIndex == UINT32_MAX)
+    {
+        blockIndex = createBlock(memoryTypeIndex, blockSizes[memoryTypeIndex], false);
+        if (!allocateFromBlock(blocks[blockIndex], order, offset))
+        {
+            throw std::runtime_error("Error! Failed to sub-allocate from new memory block!");
+        }
+    }
+
+    MemoryBlock& block = blocks[blockIndex];
+
+    allocation.block = blockIndex;
+    allocation.memory = block.memory;
+    allocation.offset = offset;
+    allocation.size = requirements.size;
+    allocation.pMapped = block.pMapped != nullptr ? static_cast<char*>(block.pMapped) + offset : nullptr;
+
+    return allocation;
+}
+
+void Allocator::free(Allocation& allocation)
+{
+    if (allocation.memory == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    MemoryBlock& block = blocks[allocation.block];
+
+    if (block.dedicated)
+    {
+        destroyBlock(allocation.block);
+    }
+    else
+    {
+        auto it = block.allocations.find(allocation.offset);
+        if (it == block.allocations.end())
+        {
+            throw std::runtime_error("Error! Freeing unknown allocation!");
+        }
+
+        uint32_t order = it->second;
+        block.allocations.erase(it);
+        block.usedBytes -= MIN_ALLOCATION_SIZE << order;
+
+        freeToBlock(block, allocation.offset, order);
+    }
+
+    allocation = {};
+}
+
+AllocatorStats Allocator::getStats()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    AllocatorStats stats = {};
+    for (const auto& block : blocks)
+    {
+        if (block.memory == VK_NULL_HANDLE)
+        {
+            continue;
+        }
+
+        stats.blockCount++;
+        stats.blockBytes += block.size;
+        stats.allocationBytes += block.usedBytes;
+
+        if (block.dedicated)
+        {
+            stats.dedicatedBlockCount++;
+            stats.allocationCount++;
+        }
+        else
+        {
+            stats.allocationCount += static_cast<uint32_t>(block.allocations.size());
+        }
+    }
+
+    return stats;
+}
+
+uint32_t Allocator::findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto key = std::make_tuple(typeBits, required, preferred);
+
+    auto it = memoryTypeCache.find(key);
+    if (it != memoryTypeCache.end())
+    {
+        return it->second;
+    }
+
+    uint32_t bestIndex = UINT32_MAX;
+    uint32_t bestPreferred = 0;
+    uint32_t bestUnwanted = UINT32_MAX;
+
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+    {
+        VkMemoryPropertyFlags flags = memoryProperties.memoryTypes[i].propertyFlags;
+
+        if ((typeBits & (1u << i)) == 0 || (flags & required) != required)
+        {
+            continue;
+        }
+
+        //prefer more of the wanted flags, then fewer flags nobody asked for (e.g. avoid device local host memory for staging)
+        uint32_t preferredCount = countBits(flags & preferred);
+        uint32_t unwantedCount = countBits(flags & ~(required | preferred));
+
+        if (bestIndex == UINT32_MAX || preferredCount > bestPreferred || (preferredCount == bestPreferred && unwantedCount < bestUnwanted))
+        {
+            bestIndex = i;
+            bestPreferred = preferredCount;
+            bestUnwanted = unwantedCount;
+        }
+    }
+
+    memoryTypeCache.insert(std::make_pair(key, bestIndex));
+
+    return bestIndex;
+}
+
+uint32_t Allocator::getHeapIndex(uint32_t memoryTypeIndex)
+{
+    return memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+}
+
+const VkPhysicalDeviceMemoryProperties& Allocator::getMemoryProperties()
+{
+    return memoryProperties;
+}
+
+std::vector<HeapBudget> Allocator::getBudget()
+{
+    std::vector<HeapBudget> budgets(memoryProperties.memoryHeapCount);
+
+    for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+    {
+        budgets[i] = {};
+        budgets[i].heapSize = memoryProperties.memoryHeaps[i].size;
+        budgets[i].flags = memoryProperties.memoryHeaps[i].flags;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        for (const auto& block : blocks)
+        {
+            if (block.memory == VK_NULL_HANDLE)
+            {
+                continue;
+            }
+
+            HeapBudget& budget = budgets[getHeapIndex(block.memoryTypeIndex)];
+            budget.blockBytes += block.size;
+            budget.allocationBytes += block.usedBytes;
+        }
+    }
+
+    if (memoryBudgetSupported)
+    {
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties = {};
+        budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+        VkPhysicalDeviceMemoryProperties2 memoryProperties2 = {};
+        memoryProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+        memoryProperties2.pNext = &budgetProperties;
+
+        vkGetPhysicalDeviceMemoryProperties2(physicalDevice, &memoryProperties2);
+
+        for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+        {
+            budgets[i].usage = budgetProperties.heapUsage[i];
+            budgets[i].budget = budgetProperties.heapBudget[i];
+        }
+    }
+    else
+    {
+        for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+        {
+            budgets[i].usage = budgets[i].blockBytes;
+            budgets[i].budget = budgets[i].heapSize / 100 * ESTIMATED_BUDGET_PERCENT;
+        }
+    }
+
+    return budgets;
+}
+
+uint32_t Allocator::createBlock(uint32_t memoryTypeIndex, VkDeviceSize size, bool dedicated)
+{
+    MemoryBlock block = {};
+    block.memoryTypeIndex = memoryTypeIndex;
+    block.size = size;
+    block.dedicated = dedicated;
+
+    VkMemoryAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &block.memory) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Error! Failed to allocate memory block!");
+    }
+
+    //host visible blocks stay mapped for their whole lifetime
+    if (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    {
+        if (vkMapMemory(device, block.memory, 0, VK_WHOLE_SIZE, 0, &block.pMapped) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Error! Failed to map memory block!");
+        }
+    }
+
+    if (!dedicated)
+    {
+        block.maxOrder = orderForSize(size);
+        block.freeLists.resize(block.maxOrder + 1);
+        block.freeLists[block.maxOrder].insert(0);
+    }
+
+    //reuse slots of released dedicated blocks so existing handles stay valid
+    for (uint32_t i = 0; i < blocks.size(); i++)
+    {
+        if (blocks[i].memory == VK_NULL_HANDLE)
+        {
+            blocks[i] = block;
+            return i;
+        }
+    }
+
+    blocks.push_back(block);
+    return static_cast<uint32_t>(blocks.size() - 1);
+}
+
+void Allocator::destroyBlock(uint32_t blockIndex)
+{
+    MemoryBlock& block = blocks[blockIndex];
+
+    if (block.memory == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    if (block.pMapped != nullptr)
+    {
+        vkUnmapMemory(device, block.memory);
+    }
+
+    vkFreeMemory(device, block.memory, nullptr);
+
+    block = {};
+}
+
+bool Allocator::allocateFromBlock(MemoryBlock& block, uint32_t order, VkDeviceSize& offset)
+{
+    if (order > block.maxOrder)
+    {
+        return false;
+    }
+
+    uint32_t freeOrder = order;
+    while (freeOrder <= block.maxOrder && block.freeLists[freeOrder].empty())
+    {
+        freeOrder++;
+    }
+
+    if (freeOrder > block.maxOrder)
+    {
+        return false;
+    }
+
+    offset = *block.freeLists[freeOrder].begin();
+    block.freeLists[freeOrder].erase(block.freeLists[freeOrder].begin());
+
+    //split the range until it matches the requested order, releasing upper halves
+    while (freeOrder > order)
+    {
+        freeOrder--;
+        block.freeLists[freeOrder].insert(offset + (MIN_ALLOCATION_SIZE << freeOrder));
+    }
+
+    block.allocations.insert(std::make_pair(offset, order));
+    block.usedBytes += MIN_ALLOCATION_SIZE << order;
+
+    return true;
+}
+
+void Allocator::freeToBlock(MemoryBlock& block, VkDeviceSize offset, uint32_t order)
+{
+    //merge with free buddies as far as possible
+    while (order < block.maxOrder)
+    {
+        VkDeviceSize buddy = offset ^ (MIN_ALLOCATION_SIZE << order);
+
+        auto it = block.freeLists[order].find(buddy);
+        if (it == block.freeLists[order].end())
+        {
+            break;
+        }
+
+        block.freeLists[order].erase(it);
+        offset = std::min(offset, buddy);
+        order++;
+    }
+
+    block.freeLists[order].insert(offset);
+}
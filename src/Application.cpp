@@ -3,9 +3,13 @@
 #include <debug.hpp>
 #include <device.hpp>
 
+#include <algorithm>
 #include <stdexcept>
+#include <thread>
 #include <vector>
 
+const uint32_t ASSET_LOADER_THREADS = 4;
+
 VkInstance instance;
 VkDebugUtilsMessengerEXT debugMessenger;
 
@@ -54,16 +58,23 @@ bool checkValidationSupport(const std::vector<const char*>& debugLayers)
 }
 
 /*! @brief Gets required instance extensions for GLFW and Debug Utils.
+ * 
+ * @param[in] headless 'true' if no surfaces will be created, GLFW extensions are then skipped
  * 
  * @return Vector containing required extensions.
  */
-std::vector<const char*> getRequiredExtensions()
+std::vector<const char*> getRequiredExtensions(bool headless)
 {
-    uint32_t glfwExtensionCount = 0;
-    const char** glfwExtensions;
-    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    std::vector<const char*> extensions;
 
-    std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    if (!headless)
+    {
+        uint32_t glfwExtensionCount = 0;
+        const char** glfwExtensions;
+        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+
+        extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    }
 
     extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 
@@ -74,8 +85,9 @@ std::vector<const char*> getRequiredExtensions()
  *
  * This function creates an instance of the Vulkan library linked with a debug messenger.
  * 
+ * @param[in] headless 'true' if only headless windows are used, GLFW is then not required
  */
-void createInstance()
+void createInstance(bool headless)
 {
     //define application info
     VkApplicationInfo applicationInfo = {};
@@ -97,7 +109,7 @@ void createInstance()
     instanceCreateInfo.pApplicationInfo = &applicationInfo;
 
     //retrieve required extensions
-    auto instanceExtensions = getRequiredExtensions();
+    auto instanceExtensions = getRequiredExtensions(headless);
 
     //requested debug layers
     const std::vector<const char*> debugLayers {
@@ -134,6 +146,18 @@ void createInstance()
     }
 }
 
+/*! @brief Destroys the debug messenger and instance created by createInstance().
+ *
+ */
+void destroyInstance()
+{
+    //destroy debugMessenger
+    destroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
+
+    //destroy instance
+    vkDestroyInstance(instance, nullptr);
+}
+
 /*! @brief Gets the vulkan instance created by the application.
  *
  * @return Vulkan instance
@@ -148,16 +172,13 @@ VkInstance getInstance()
  */
 Application::Application()
 {
-    //initialise glfw
-    if (!glfwInit())
-    {
-        throw std::runtime_error("Error! Failed to initialise GLFW!");
-    }
+    glfwInitialised = false;
+    windowThreads = nullptr;
 
-    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    deviceRegistry.create();
+    assetLoader.create(ASSET_LOADER_THREADS);
 
-    Window primaryWindow;
-    windows.push_back(primaryWindow);
+    windows.push_back(new Window());
 }
 
 /*! @brief Implementation of default destructor for 'Application' class.
@@ -166,43 +187,151 @@ Application::Application()
  */
 Application::~Application()
 {
-    for (Window window : windows)
+    if (windowThreads != nullptr)
     {
-        window.destroy();
+        windowThreads->destroy();
+        delete windowThreads;
     }
 
-    for (Device device : devices)
+    //callbacks still queued may refer to the windows
+    assetLoader.destroy();
+
+    for (Window* window : windows)
     {
-        device.destroy();
+        window->destroy();
+        delete window;
     }
 
-    //destroy debugMessenger
-    destroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
+    deviceRegistry.destroy();
 
-    //destroy instance
-    vkDestroyInstance(instance, nullptr);
+    destroyInstance();
 
+    if (glfwInitialised)
+    {
+        glfwTerminate();
+    }
 }
 
 /*! @brief Implementation of Application::run().
  *
- * This function calls start() followed by createInstance().
+ * This function calls start() followed by createInstance(). GLFW is only initialised if a window
+ * needs a surface, so applications with only headless windows run without a display.
  */
 void Application::run()
 {
-    createInstance();
+    start(*windows[0]);
+
+    bool headless = true;
+    for (Window* window : windows)
+    {
+        headless = headless && window->isHeadless();
+    }
+
+    if (!headless)
+    {
+        //initialise glfw
+        if (!glfwInit())
+        {
+            throw std::runtime_error("Error! Failed to initialise GLFW!");
+        }
+
+        glfwInitialised = true;
+
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    }
+
+    createInstance(headless);
+
+    //windows with a surface launch first, their devices can then serve headless windows as well
+    std::vector<Window*> launchOrder = windows;
+    std::stable_partition(launchOrder.begin(), launchOrder.end(), [](Window* window) {
+        return !window->isHeadless();
+    });
 
-    start(windows[0]);
+    //windows render in parallel, each records on its share of the cores instead of all of them
+    if (windows.size() > 1)
+    {
+        uint32_t windowCount = static_cast<uint32_t>(windows.size());
+        uint32_t recordThreadCount = std::max(std::thread::hardware_concurrency() / windowCount, 2u) - 1;
+
+        for (Window* window : windows)
+        {
+            //counts chosen in start() are kept
+            if (window->getRecordThreadCount() == 0)
+            {
+                window->setRecordThreadCount(recordThreadCount);
+            }
+        }
+    }
+
+    for (Window* window : launchOrder)
+    {
+        window->launch(deviceRegistry, assetLoader);
+    }
 
-    windows[0].launch(devices);
+    //one thread per window, a single window renders on the main thread
+    if (windows.size() > 1)
+    {
+        windowThreads = new ThreadPool();
+        windowThreads->create(static_cast<uint32_t>(windows.size()));
+    }
 
-    while(!windows[0].shouldClose())
+    std::vector<Window*> activeWindows;
+    std::vector<FramePresent> frames;
+
+    while(!windows[0]->shouldClose())
     {
-        glfwPollEvents();
+        if (glfwInitialised)
+        {
+            glfwPollEvents();
+        }
+
+        //assets finished since the last frame hand their results to the upload path here, which is not thread safe
+        assetLoader.dispatchCompleted();
+
+        //closed secondary windows stop rendering, the rest of the application keeps running
+        activeWindows.clear();
+        for (Window* window : windows)
+        {
+            if (!window->shouldClose())
+            {
+                window->prepareFrame();
+                activeWindows.push_back(window);
+            }
+        }
+
+        frames.assign(activeWindows.size(), FramePresent());
+
+        if (activeWindows.size() == 1)
+        {
+            frames[0] = activeWindows[0]->renderFrame();
+        }
+        else
+        {
+            windowThreads->run(static_cast<uint32_t>(activeWindows.size()), [&](uint32_t task, uint32_t worker)
+            {
+                frames[task] = activeWindows[task]->renderFrame();
+            });
+        }
+
+        //swapchains sharing a present queue are presented in one call instead of one per window
+        std::vector<VkResult> results = presentFrames(frames);
 
-        for (Window window : windows)
+        for (size_t i = 0; i < activeWindows.size(); i++)
         {
-            window.drawFrame();
+            if (frames[i].rendered)
+            {
+                activeWindows[i]->finishFrame(results[i]);
+            }
         }
     }
 }
+
+/*! @brief Implementation of Application::createWindow().
+ *
+ */
+Window& Application::createWindow()
+{
+    windows.push_back(new Window());
+    return *windows.back();
+}
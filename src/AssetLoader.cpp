@@ -0,0 +1,204 @@
+#include <assetloader.hpp>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+bool AssetLoader::Job::operator<(const Job& other) const
+{
+    //priority_queue pops the largest element, earlier submissions win ties
+    if (priority != other.priority)
+    {
+        return priority < other.priority;
+    }
+    return sequence > other.sequence;
+}
+
+AssetLoader::AssetLoader()
+{
+
+}
+
+AssetLoader::~AssetLoader()
+{
+
+}
+
+void AssetLoader::create(uint32_t threadCount, const std::string& rootPath)
+{
+    this->rootPath = rootPath;
+
+    nextSequence = 0;
+    runningJobs = 0;
+    stopping = false;
+
+    threadCount = std::max(threadCount, 1u);
+    for (uint32_t i = 0; i < threadCount; i++)
+    {
+        threads.emplace_back(&AssetLoader::work, this);
+    }
+}
+
+void AssetLoader::destroy()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        //queued jobs still run so their futures are failed, but they skip the disk
+        std::priority_queue<Job> queued = jobs;
+        while (!queued.empty())
+        {
+            queued.top().state->cancelled = true;
+            queued.pop();
+        }
+
+        stopping = true;
+    }
+    workAvailable.notify_all();
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    threads.clear();
+
+    std::lock_guard<std::mutex> lock(completedMutex);
+    completed.clear();
+}
+
+AssetHandle<std::vector<char>> AssetLoader::load(const std::string& path, AssetPriority priority)
+{
+    return load<std::vector<char>>(path, [](std::vector<char>& data)
+    {
+        return std::move(data);
+    }, priority);
+}
+
+uint32_t AssetLoader::dispatchCompleted(uint32_t maxCount)
+{
+    uint32_t count = 0;
+    while (count < maxCount)
+    {
+        std::function<void()> callback;
+        {
+            std::lock_guard<std::mutex> lock(completedMutex);
+            if (completed.empty())
+            {
+                break;
+            }
+
+            callback = std::move(completed.front());
+            completed.pop_front();
+        }
+
+        //run unlocked, callbacks may request further assets
+        callback();
+        count++;
+    }
+    return count;
+}
+
+uint32_t AssetLoader::getPendingCount()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    return static_cast<uint32_t>(jobs.size()) + runningJobs;
+}
+
+uint32_t AssetLoader::getThreadCount()
+{
+    return static_cast<uint32_t>(threads.size());
+}
+
+std::vector<char> AssetLoader::readAsset(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Error! Failed to open file: " + path);
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0)
+    {
+        close(fd);
+        throw std::runtime_error("Error! Failed to stat file: " + path);
+    }
+
+    std::vector<char> data(static_cast<size_t>(fileStat.st_size));
+
+    //read straight into the result, no stream buffering in between
+    size_t offset = 0;
+    while (offset < data.size())
+    {
+        ssize_t bytesRead = read(fd, data.data() + offset, data.size() - offset);
+        if (bytesRead <= 0)
+        {
+            close(fd);
+            throw std::runtime_error("Error! Failed to read file: " + path);
+        }
+
+        offset += static_cast<size_t>(bytesRead);
+    }
+
+    close(fd);
+
+    return data;
+}
+
+void AssetLoader::submit(AssetPriority priority, const std::shared_ptr<AssetRequestState>& state, const std::function<void()>& run)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (stopping)
+        {
+            state->cancelled = true;
+        }
+
+        Job job = {};
+        job.priority = priority;
+        job.sequence = nextSequence++;
+        job.state = state;
+        job.run = run;
+        jobs.push(job);
+    }
+    workAvailable.notify_one();
+}
+
+void AssetLoader::complete(const std::function<void()>& callback)
+{
+    std::lock_guard<std::mutex> lock(completedMutex);
+
+    completed.push_back(callback);
+}
+
+void AssetLoader::work()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true)
+    {
+        workAvailable.wait(lock, [this] { return stopping || !jobs.empty(); });
+
+        //drain the queue before stopping so no future is left without a result
+        if (jobs.empty())
+        {
+            return;
+        }
+
+        Job job = jobs.top();
+        jobs.pop();
+        runningJobs++;
+
+        lock.unlock();
+
+        job.run();
+
+        lock.lock();
+
+        runningJobs--;
+    }
+}
@@ -0,0 +1,149 @@
+#include <cullpass.hpp>
+
+#include <device.hpp>
+
+#include <map>
+#include <stdexcept>
+
+CullPass::CullPass()
+{
+
+}
+
+CullPass::~CullPass()
+{
+
+}
+
+void CullPass::create(Device& device, uint32_t setCount, VkShaderModule shaderModule)
+{
+    ShaderReflection reflection = device.getShaderLibrary()->getReflection(shaderModule);
+
+    if (reflection.stage != VK_SHADER_STAGE_COMPUTE_BIT)
+    {
+        throw std::runtime_error("Error! Cull shader is not a compute shader!");
+    }
+
+    if (reflection.pushConstantSize != sizeof(CullParams))
+    {
+        throw std::runtime_error("Error! Cull shader push constants do not match CullParams!");
+    }
+
+    //set and pipeline layout are shared through the device, destroy() leaves them alone
+    PipelineLayoutInfo layoutInfo = device.getLayoutCache()->getPipelineLayout({reflection});
+
+    //record() writes instances, draw commands and draw count to bindings 0 to 2 of set 0
+    if (layoutInfo.setBindings.size() != 1 || layoutInfo.setBindings[0].size() != 3)
+    {
+        throw std::runtime_error("Error! Cull shader bindings do not match the cull pass!");
+    }
+
+    setLayout = layoutInfo.setLayouts[0];
+    layout = layoutInfo.layout;
+    groupSize = reflection.localSize[0];
+
+    std::map<VkDescriptorType, uint32_t> descriptorCounts;
+    for (const auto& binding : layoutInfo.setBindings[0])
+    {
+        descriptorCounts[binding.descriptorType] += setCount * binding.descriptorCount;
+    }
+
+    std::vector<VkDescriptorPoolSize> poolSizes;
+    for (const auto& descriptorCount : descriptorCounts)
+    {
+        VkDescriptorPoolSize poolSize = {};
+        poolSize.type = descriptorCount.first;
+        poolSize.descriptorCount = descriptorCount.second;
+        poolSizes.push_back(poolSize);
+    }
+
+    VkDescriptorPoolCreateInfo poolCreateInfo = {};
+    poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolCreateInfo.maxSets = setCount;
+    poolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolCreateInfo.pPoolSizes = poolSizes.data();
+
+    if (device.createDescriptorPool(&poolCreateInfo, nullptr, &descriptorPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Error! Failed to create cull descriptor pool!");
+    }
+
+    std::vector<VkDescriptorSetLayout> setLayouts(setCount, setLayout);
+    descriptorSets.resize(setCount);
+
+    VkDescriptorSetAllocateInfo setAllocateInfo = {};
+    setAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    setAllocateInfo.descriptorPool = descriptorPool;
+    setAllocateInfo.descriptorSetCount = setCount;
+    setAllocateInfo.pSetLayouts = setLayouts.data();
+
+    if (device.allocateDescriptorSets(&setAllocateInfo, descriptorSets.data()) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Error! Failed to allocate cull descriptor sets!");
+    }
+
+    VkComputePipelineCreateInfo pipelineCreateInfo = {};
+    pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineCreateInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineCreateInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineCreateInfo.stage.module = shaderModule;
+    pipelineCreateInfo.stage.pName = reflection.entryPoint.c_str();
+    pipelineCreateInfo.layout = layout;
+    pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
+    pipelineCreateInfo.basePipelineIndex = -1;
+
+    if (device.createComputePipelines(device.getPipelineCache(), 1, &pipelineCreateInfo, nullptr, &pipeline) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Error! Failed to create cull pipeline!");
+    }
+}
+
+void CullPass::destroy(Device& device)
+{
+    device.destroyPipeline(pipeline, nullptr);
+
+    //destroying the pool frees its sets
+    device.destroyDescriptorPool(descriptorPool, nullptr);
+
+    descriptorSets.clear();
+}
+
+void CullPass::record(Device& device, VkCommandBuffer commandBuffer, uint32_t set, VkBuffer instanceBuffer, DrawList& drawList, const CullParams& params)
+{
+    VkDescriptorBufferInfo bufferInfos[3] = {};
+    bufferInfos[0].buffer = instanceBuffer;
+    bufferInfos[0].range = VK_WHOLE_SIZE;
+    bufferInfos[1].buffer = drawList.getCommandBuffer();
+    bufferInfos[1].range = VK_WHOLE_SIZE;
+    bufferInfos[2].buffer = drawList.getCountBuffer();
+    bufferInfos[2].range = VK_WHOLE_SIZE;
+
+    //buffers may have been reallocated since the set was last used
+    VkWriteDescriptorSet descriptorWrites[3] = {};
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[i].dstSet = descriptorSets[set];
+        descriptorWrites[i].dstBinding = i;
+        descriptorWrites[i].descriptorCount = 1;
+        descriptorWrites[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[i].pBufferInfo = &bufferInfos[i];
+    }
+
+    device.updateDescriptorSets(3, descriptorWrites);
+
+    vkCmdFillBuffer(commandBuffer, drawList.getCountBuffer(), 0, sizeof(uint32_t), 0);
+
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, layout, 0, 1, &descriptorSets[set], 0, nullptr);
+    vkCmdPushConstants(commandBuffer, layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullParams), &params);
+
+    vkCmdDispatch(commandBuffer, (params.objectCount + groupSize - 1) / groupSize, 1, 1);
+}
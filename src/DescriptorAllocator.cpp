@@ -0,0 +1,113 @@
+#include <descriptorallocator.hpp>
+
+#include <device.hpp>
+
+#include <stdexcept>
+
+DescriptorAllocator::DescriptorAllocator()
+{
+
+}
+
+DescriptorAllocator::~DescriptorAllocator()
+{
+
+}
+
+void DescriptorAllocator::create(const std::vector<VkDescriptorPoolSize>& poolSizes, uint32_t maxSets)
+{
+    this->poolSizes = poolSizes;
+    this->maxSets = maxSets;
+}
+
+void DescriptorAllocator::destroy(Device& device)
+{
+    //destroying a pool frees its sets
+    for (VkDescriptorPool pool : usedPools)
+    {
+        device.destroyDescriptorPool(pool, nullptr);
+    }
+    for (VkDescriptorPool pool : freePools)
+    {
+        device.destroyDescriptorPool(pool, nullptr);
+    }
+
+    usedPools.clear();
+    freePools.clear();
+}
+
+VkDescriptorSet DescriptorAllocator::allocate(Device& device, VkDescriptorSetLayout layout)
+{
+    if (usedPools.empty())
+    {
+        usedPools.push_back(acquirePool(device));
+    }
+
+    VkDescriptorSetAllocateInfo setAllocateInfo = {};
+    setAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    setAllocateInfo.descriptorPool = usedPools.back();
+    setAllocateInfo.descriptorSetCount = 1;
+    setAllocateInfo.pSetLayouts = &layout;
+
+    VkDescriptorSet set;
+    VkResult result = device.allocateDescriptorSets(&setAllocateInfo, &set);
+
+    //the current pool is full, continue in a fresh one
+    if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+    {
+        usedPools.push_back(acquirePool(device));
+        setAllocateInfo.descriptorPool = usedPools.back();
+
+        result = device.allocateDescriptorSets(&setAllocateInfo, &set);
+    }
+
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("Error! Failed to allocate descriptor set!");
+    }
+
+    return set;
+}
+
+void DescriptorAllocator::reset(Device& device)
+{
+    for (VkDescriptorPool pool : usedPools)
+    {
+        if (device.resetDescriptorPool(pool, 0) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Error! Failed to reset descriptor pool!");
+        }
+        freePools.push_back(pool);
+    }
+
+    usedPools.clear();
+}
+
+uint32_t DescriptorAllocator::getPoolCount()
+{
+    return static_cast<uint32_t>(usedPools.size() + freePools.size());
+}
+
+VkDescriptorPool DescriptorAllocator::acquirePool(Device& device)
+{
+    if (!freePools.empty())
+    {
+        VkDescriptorPool pool = freePools.back();
+        freePools.pop_back();
+        return pool;
+    }
+
+    VkDescriptorPoolCreateInfo poolCreateInfo = {};
+    poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolCreateInfo.maxSets = maxSets;
+    poolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolCreateInfo.pPoolSizes = poolSizes.data();
+
+    VkDescriptorPool pool;
+    if (device.createDescriptorPool(&poolCreateInfo, nullptr, &pool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Error! Failed to create descriptor pool!");
+    }
+
+    return pool;
+}
@@ -1,14 +1,25 @@
 #include <device.hpp>
 
+#include <geometrycache.hpp>
 #include <utils.hpp>
 
 #include <math.h>
+#include <string.h>
 
+#include <algorithm>
 #include <array>
+#include <chrono>
 #include <iostream>
 #include <map>
 #include <set>
 
+const VkDeviceSize STAGING_RING_SIZE = 16 * 1024 * 1024;
+
+const char* PIPELINE_CACHE_PATH = "build/resources/pipeline.cache";
+
+//resident SPIR-V lets modules be recreated and reflected without touching the disk
+const bool SHADER_LIBRARY_KEEP_CODE = true;
+
 const std::vector<const char*> requestedDeviceExtensions = {
     VK_KHR_SWAPCHAIN_EXTENSION_NAME
 };
@@ -79,7 +90,8 @@ std::vector<QueueFamily> getPhysicalDeviceQueueFamilies(VkPhysicalDevice physica
 
             if (requestedUse > maxAvailableUse && queueFamilies[j].queueFlags & queueFlag)
             {
-                if ((queueFlag & VK_QUEUE_GRAPHICS_BIT) == queueFlag)
+                //headless devices render offscreen and never present
+                if ((queueFlag & VK_QUEUE_GRAPHICS_BIT) == queueFlag && surface != VK_NULL_HANDLE)
                 {
                     VkBool32 presentSupport;
                     vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, j, surface, &presentSupport);
@@ -98,9 +110,11 @@ std::vector<QueueFamily> getPhysicalDeviceQueueFamilies(VkPhysicalDevice physica
         for (int j = 0; j < requestedQueueCounts[queueToFind]; j++)
         {
             int queueToUse = queueFamilyAvailability[queueFamilyToUse];
-            if (queueToUse >= queueFamilies[queueFamilyToUse].queueCount)
+            if (queueToUse < 0 || queueToUse >= queueFamilies[queueFamilyToUse].queueCount)
             {
-                queueToUse = queueToUse % queueFamilies[queueFamilyToUse].queueCount;
+                //families with fewer queues than requested (e.g. software rasterisers) share them
+                int queueCount = queueFamilies[queueFamilyToUse].queueCount;
+                queueToUse = ((queueToUse % queueCount) + queueCount) % queueCount;
             }
 
             QueueFamily requestedQueue = {};
@@ -135,6 +149,25 @@ bool deviceExtensionsSupported(VkPhysicalDevice device)
     return requiredExtensions.empty();
 }
 
+bool deviceExtensionSupported(VkPhysicalDevice device, const char* extensionName)
+{
+    uint32_t extensionCount;
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+    std::vector<VkExtensionProperties> deviceExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, deviceExtensions.data());
+
+    for (const auto& extension : deviceExtensions)
+    {
+        if (strcmp(extension.extensionName, extensionName) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 SwapchainSupportDetails querySwapchainSupportDetails(VkPhysicalDevice device, VkSurfaceKHR& surface)
 {
     SwapchainSupportDetails details;
@@ -178,6 +211,12 @@ int rateDevice(VkPhysicalDevice device, VkSurfaceKHR& surface)
 
     rating += uniqueQueues.size();
 
+    //without a surface only rendering capability matters
+    if (surface == VK_NULL_HANDLE)
+    {
+        return rating;
+    }
+
     if (!extensionsSupported)
     {
         rating = -1;
@@ -224,7 +263,27 @@ VkPhysicalDevice selectPhysicalDevice(VkSurfaceKHR& surface)
 
 Device::Device()
 {
-
+    allocator = nullptr;
+    stagingRing = nullptr;
+    pipelineCache = nullptr;
+    shaderLibrary = nullptr;
+    layoutCache = nullptr;
+    geometryCache = nullptr;
+    queueMutexes = nullptr;
+    uploadMutex = nullptr;
+
+    lastUploadSerial = 0;
+
+    swapchainSupported = false;
+
+    extendedDynamicStateSupported = false;
+    pfnCmdSetCullMode = nullptr;
+    pfnCmdSetFrontFace = nullptr;
+    pfnCmdSetPrimitiveTopology = nullptr;
+
+    enabledFeatures = {};
+    drawIndirectCountSupported = false;
+    pfnCmdDrawIndexedIndirectCount = nullptr;
 }
 
 Device::~Device()
@@ -252,26 +311,84 @@ void Device::create(VkSurfaceKHR& surface)
     }
     for (auto queueFamily : queueFamilies)
     {
-        uniqueQueueFamilies.find(queueFamily.queueFamilyIndex)->second++;
+        //create as many queues as the highest index used, shared queues are only created once
+        uint32_t& queueCount = uniqueQueueFamilies.find(queueFamily.queueFamilyIndex)->second;
+        queueCount = std::max(queueCount, queueFamily.queueIndex + 1);
+    }
+
+    uint32_t maxQueueCount = 0;
+    for (std::pair queueFamily : uniqueQueueFamilies)
+    {
+        maxQueueCount = std::max(maxQueueCount, queueFamily.second);
     }
 
-    float queuePriority = 1.0f;
+    std::vector<float> queuePriorities(maxQueueCount, 1.0f);
     for (std::pair queueFamily : uniqueQueueFamilies)
     {
         VkDeviceQueueCreateInfo queueCreateInfo = {};
         queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
         queueCreateInfo.queueFamilyIndex = queueFamily.first;
         queueCreateInfo.queueCount = queueFamily.second;
-        queueCreateInfo.pQueuePriorities = &queuePriority;
+        queueCreateInfo.pQueuePriorities = queuePriorities.data();
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
+    std::vector<const char*> deviceExtensions;
+    swapchainSupported = surface != VK_NULL_HANDLE;
+    if (swapchainSupported)
+    {
+        deviceExtensions = requestedDeviceExtensions;
+    }
+
+    //optional, without it budgets are estimated from heap sizes
+    bool memoryBudgetSupported = deviceExtensionSupported(physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    if (memoryBudgetSupported)
+    {
+        deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
+
+    //optional, without it cull mode, front face and topology stay baked into pipelines
+    VkPhysicalDeviceExtendedDynamicStateFeaturesEXT extendedDynamicStateFeatures = {};
+    extendedDynamicStateFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+
+    if (deviceExtensionSupported(physicalDevice, VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME))
+    {
+        VkPhysicalDeviceFeatures2 features = {};
+        features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features.pNext = &extendedDynamicStateFeatures;
+
+        vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+    }
+
+    extendedDynamicStateSupported = extendedDynamicStateFeatures.extendedDynamicState == VK_TRUE;
+    if (extendedDynamicStateSupported)
+    {
+        deviceExtensions.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME);
+    }
+
+    //optional, without it the draw count of indirect draws is fixed at record time
+    drawIndirectCountSupported = deviceExtensionSupported(physicalDevice, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+    if (drawIndirectCountSupported)
+    {
+        deviceExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+    }
+
+    VkPhysicalDeviceFeatures supportedFeatures = {};
+    vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
+    //needed to draw many meshes from one indirect buffer
+    enabledFeatures = {};
+    enabledFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+    enabledFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+
     VkDeviceCreateInfo deviceCreateInfo = {};
     deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    deviceCreateInfo.pEnabledFeatures = &enabledFeatures;
+    deviceCreateInfo.pNext = extendedDynamicStateSupported ? &extendedDynamicStateFeatures : nullptr;
     deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     deviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();
-    deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(requestedDeviceExtensions.size());
-    deviceCreateInfo.ppEnabledExtensionNames = requestedDeviceExtensions.data();
+    deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
+    deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions.data();
     deviceCreateInfo.enabledLayerCount = static_cast<uint32_t>(debugLayers.size());
     deviceCreateInfo.ppEnabledLayerNames = debugLayers.data();
 
@@ -280,6 +397,30 @@ void Device::create(VkSurfaceKHR& surface)
         throw std::runtime_error("Error! Failed to create device!");
     }
 
+    if (extendedDynamicStateSupported)
+    {
+        pfnCmdSetCullMode = (PFN_vkCmdSetCullModeEXT) vkGetDeviceProcAddr(device, "vkCmdSetCullModeEXT");
+        pfnCmdSetFrontFace = (PFN_vkCmdSetFrontFaceEXT) vkGetDeviceProcAddr(device, "vkCmdSetFrontFaceEXT");
+        pfnCmdSetPrimitiveTopology = (PFN_vkCmdSetPrimitiveTopologyEXT) vkGetDeviceProcAddr(device, "vkCmdSetPrimitiveTopologyEXT");
+
+        if (pfnCmdSetCullMode == nullptr || pfnCmdSetFrontFace == nullptr || pfnCmdSetPrimitiveTopology == nullptr)
+        {
+            std::cout << "Warning! Failed to load extended dynamic state commands!" << std::endl;
+            extendedDynamicStateSupported = false;
+        }
+    }
+
+    if (drawIndirectCountSupported)
+    {
+        pfnCmdDrawIndexedIndirectCount = (PFN_vkCmdDrawIndexedIndirectCountKHR) vkGetDeviceProcAddr(device, "vkCmdDrawIndexedIndirectCountKHR");
+
+        if (pfnCmdDrawIndexedIndirectCount == nullptr)
+        {
+            std::cout << "Warning! Failed to load indirect count draw command!" << std::endl;
+            drawIndirectCountSupported = false;
+        }
+    }
+
     for (auto queueFamily : queueFamilies)
     {
         VkQueue vQueue;
@@ -296,6 +437,16 @@ void Device::create(VkSurfaceKHR& surface)
         }
     }
 
+    //families with a single queue hand out the same VkQueue several times, those share one lock
+    queueMutexes = new std::map<VkQueue, std::mutex>();
+    for (const std::vector<Queue>* pQueues : {&graphicsQueues, &transferQueues, &computeQueues})
+    {
+        for (const auto& queue : *pQueues)
+        {
+            (*queueMutexes)[queue.queue];
+        }
+    }
+
     for (std::map<uint32_t, uint32_t>::iterator it = uniqueQueueFamilies.begin(); it != uniqueQueueFamilies.end(); ++it)
     {
         VkCommandPoolCreateInfo poolCreateInfo = {};
@@ -310,17 +461,84 @@ void Device::create(VkSurfaceKHR& surface)
         }
 
         commandPools.insert(std::make_pair(it->first, pool));
+
+        VkCommandPool uploadPool;
+        if (createCommandPool(&poolCreateInfo, nullptr, &uploadPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Error! Failed to create upload command pool!");
+        }
+
+        uploadPools.insert(std::make_pair(it->first, uploadPool));
     }
+
+    uploadMutex = new std::recursive_mutex();
+
+    allocator = new Allocator();
+    allocator->create(physicalDevice, device, memoryBudgetSupported);
+
+    createBuffer(STAGING_RING_SIZE, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferAllocation);
+
+    stagingRing = new StagingRing();
+    stagingRing->create(device, stagingBuffer, stagingBufferAllocation.pMapped, STAGING_RING_SIZE);
+
+    pipelineCache = new PipelineCache();
+    pipelineCache->create(physicalDevice, device, PIPELINE_CACHE_PATH);
+
+    shaderLibrary = new ShaderLibrary();
+    shaderLibrary->create(device, SHADER_LIBRARY_KEEP_CODE);
+
+    layoutCache = new LayoutCache();
+    layoutCache->create(device);
+
+    geometryCache = new GeometryCache();
+    geometryCache->create();
 }
 
 void Device::destroy()
 {
+    geometryCache->destroy(*this);
+    delete geometryCache;
+    geometryCache = nullptr;
+
+    layoutCache->destroy();
+    delete layoutCache;
+    layoutCache = nullptr;
+
+    shaderLibrary->destroy();
+    delete shaderLibrary;
+    shaderLibrary = nullptr;
+
+    pipelineCache->destroy();
+    delete pipelineCache;
+    pipelineCache = nullptr;
+
+    stagingRing->destroy();
+    delete stagingRing;
+    stagingRing = nullptr;
+
+    destroyBuffer(stagingBuffer, stagingBufferAllocation);
+
+    allocator->destroy();
+    delete allocator;
+    allocator = nullptr;
+
     for (std::map<uint32_t, VkCommandPool>::iterator it = commandPools.begin(); it != commandPools.end(); ++it)
     {
         vkDestroyCommandPool(device, it->second, nullptr);
     }
 
+    for (std::map<uint32_t, VkCommandPool>::iterator it = uploadPools.begin(); it != uploadPools.end(); ++it)
+    {
+        vkDestroyCommandPool(device, it->second, nullptr);
+    }
+
     vkDestroyDevice(device, nullptr);
+
+    delete queueMutexes;
+    queueMutexes = nullptr;
+
+    delete uploadMutex;
+    uploadMutex = nullptr;
 }
 
 VkResult Device::createBuffer(VkBufferCreateInfo* pCreateInfo, VkAllocationCallbacks* pAllocator, VkBuffer* pBuffer)
@@ -328,7 +546,7 @@ VkResult Device::createBuffer(VkBufferCreateInfo* pCreateInfo, VkAllocationCallb
     return vkCreateBuffer(device, pCreateInfo, pAllocator, pBuffer);
 }
 
-void Device::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& memory)
+void Device::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, Allocation& allocation)
 {
     VkBufferCreateInfo bufferCreateInfo = {};
     bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -336,7 +554,31 @@ void Device::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryP
     bufferCreateInfo.usage = usage;
     bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-    if (createBuffer(&bufferCreateInfo, nullptr, &buffer) != VK_SUCCESS)
+    createBuffer(&bufferCreateInfo, properties, buffer, allocation);
+}
+
+void Device::createSharedBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, Allocation& allocation)
+{
+    std::vector<uint32_t> queueFamilies = {graphicsQueues[0].family.queueFamilyIndex};
+    if (!computeQueues.empty() && computeQueues[0].family.queueFamilyIndex != queueFamilies[0])
+    {
+        queueFamilies.push_back(computeQueues[0].family.queueFamilyIndex);
+    }
+
+    VkBufferCreateInfo bufferCreateInfo = {};
+    bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferCreateInfo.size = size;
+    bufferCreateInfo.usage = usage;
+    bufferCreateInfo.sharingMode = queueFamilies.size() > 1 ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
+    bufferCreateInfo.queueFamilyIndexCount = queueFamilies.size() > 1 ? static_cast<uint32_t>(queueFamilies.size()) : 0;
+    bufferCreateInfo.pQueueFamilyIndices = queueFamilies.size() > 1 ? queueFamilies.data() : nullptr;
+
+    createBuffer(&bufferCreateInfo, properties, buffer, allocation);
+}
+
+void Device::createBuffer(VkBufferCreateInfo* pCreateInfo, VkMemoryPropertyFlags properties, VkBuffer& buffer, Allocation& allocation)
+{
+    if (createBuffer(pCreateInfo, nullptr, &buffer) != VK_SUCCESS)
     {
         throw std::runtime_error("Error! Failed to create buffer!");
     }
@@ -344,17 +586,32 @@ void Device::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryP
     VkMemoryRequirements memRequirements;
     getBufferMemoryRequirements(buffer, &memRequirements);
 
-    VkMemoryAllocateInfo allocInfo = {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+    uint32_t memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+    allocation = allocator->allocate(memRequirements, memoryTypeIndex, true);
+
+    if (bindBufferMemory(buffer, allocation.memory, allocation.offset) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Error! Failed to bind buffer memory!");
+    }
+}
 
-    if (allocateMemory(&allocInfo, nullptr, &memory) != VK_SUCCESS)
+void Device::createImage(VkImageCreateInfo* pCreateInfo, VkMemoryPropertyFlags properties, VkImage& image, Allocation& allocation)
+{
+    if (vkCreateImage(device, pCreateInfo, nullptr, &image) != VK_SUCCESS)
     {
-        throw std::runtime_error("Error! Failed to allocate buffer memory!");
+        throw std::runtime_error("Error! Failed to create image!");
     }
 
-    bindBufferMemory(buffer, memory, 0);
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(device, image, &memRequirements);
+
+    uint32_t memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+    allocation = allocator->allocate(memRequirements, memoryTypeIndex, pCreateInfo->tiling == VK_IMAGE_TILING_LINEAR);
+
+    if (vkBindImageMemory(device, image, allocation.memory, allocation.offset) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Error! Failed to bind image memory!");
+    }
 }
 
 VkResult Device::createCommandPool(VkCommandPoolCreateInfo* pCreateInfo, VkAllocationCallbacks* pAllocator, VkCommandPool* pPool)
@@ -362,6 +619,32 @@ VkResult Device::createCommandPool(VkCommandPoolCreateInfo* pCreateInfo, VkAlloc
     return vkCreateCommandPool(device, pCreateInfo, pAllocator, pPool);
 }
 
+VkResult Device::createComputePipelines(VkPipelineCache cache, uint32_t createInfoCount, const VkComputePipelineCreateInfo* pCreateInfos, VkAllocationCallbacks* pAllocator, VkPipeline* pPipelines)
+{
+    if (cache == VK_NULL_HANDLE)
+    {
+        cache = pipelineCache->getThreadCache();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    VkResult result = vkCreateComputePipelines(device, cache, createInfoCount, pCreateInfos, pAllocator, pPipelines);
+
+    pipelineCache->recordCreation(createInfoCount, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+    return result;
+}
+
+VkResult Device::createDescriptorPool(VkDescriptorPoolCreateInfo* pCreateInfo, VkAllocationCallbacks* pAllocator, VkDescriptorPool* pPool)
+{
+    return vkCreateDescriptorPool(device, pCreateInfo, pAllocator, pPool);
+}
+
+VkResult Device::createDescriptorSetLayout(VkDescriptorSetLayoutCreateInfo* pCreateInfo, VkAllocationCallbacks* pAllocator, VkDescriptorSetLayout* pLayout)
+{
+    return vkCreateDescriptorSetLayout(device, pCreateInfo, pAllocator, pLayout);
+}
+
 VkResult Device::createFence(VkFenceCreateInfo* pCreateInfo, VkAllocationCallbacks* pAllocator, VkFence* pFence)
 {
     return vkCreateFence(device, pCreateInfo, pAllocator, pFence);
@@ -372,9 +655,20 @@ VkResult Device::createFramebuffer(VkFramebufferCreateInfo* pCreateInfo, VkAlloc
     return vkCreateFramebuffer(device, pCreateInfo, pAllocator, pFramebuffer);
 }
 
-VkResult Device::createGraphicsPipelines(VkPipelineCache pipelineCache, uint32_t createInfoCount, const VkGraphicsPipelineCreateInfo* pCreateInfos, VkAllocationCallbacks* pAllocator, VkPipeline* pPipelines)
+VkResult Device::createGraphicsPipelines(VkPipelineCache cache, uint32_t createInfoCount, const VkGraphicsPipelineCreateInfo* pCreateInfos, VkAllocationCallbacks* pAllocator, VkPipeline* pPipelines)
 {
-    return vkCreateGraphicsPipelines(device, pipelineCache, createInfoCount, pCreateInfos, pAllocator, pPipelines);
+    if (cache == VK_NULL_HANDLE)
+    {
+        cache = pipelineCache->getThreadCache();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    VkResult result = vkCreateGraphicsPipelines(device, cache, createInfoCount, pCreateInfos, pAllocator, pPipelines);
+
+    pipelineCache->recordCreation(createInfoCount, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+    return result;
 }
 
 VkResult Device::createImageView(VkImageViewCreateInfo* pCreateInfo, VkAllocationCallbacks* pAllocator, VkImageView* pImageView)
@@ -422,11 +716,31 @@ void Device::freeMemory(VkDeviceMemory memory, VkAllocationCallbacks* pAllocator
     vkFreeMemory(device, memory, pAllocator);
 }
 
+VkResult Device::allocateDescriptorSets(VkDescriptorSetAllocateInfo* pAllocInfo, VkDescriptorSet* pSets)
+{
+    return vkAllocateDescriptorSets(device, pAllocInfo, pSets);
+}
+
+VkResult Device::resetDescriptorPool(VkDescriptorPool pool, VkDescriptorPoolResetFlags flags)
+{
+    return vkResetDescriptorPool(device, pool, flags);
+}
+
+void Device::updateDescriptorSets(uint32_t writeCount, const VkWriteDescriptorSet* pWrites)
+{
+    vkUpdateDescriptorSets(device, writeCount, pWrites, 0, nullptr);
+}
+
 VkResult Device::allocateCommandBuffers(VkCommandBufferAllocateInfo* pAllocInfo, VkCommandBuffer* pBuffers)
 {
     return vkAllocateCommandBuffers(device, pAllocInfo, pBuffers);
 }
 
+VkResult Device::resetCommandPool(VkCommandPool pool, VkCommandPoolResetFlags flags)
+{
+    return vkResetCommandPool(device, pool, flags);
+}
+
 void Device::freeCommandBuffers(VkCommandPool pool, uint32_t bufferCount, VkCommandBuffer* pBuffers)
 {
     vkFreeCommandBuffers(device, pool, bufferCount, pBuffers);
@@ -445,16 +759,350 @@ void Device::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize siz
     endSingleTimeCommands(commandBuffer, pool, queue);
 }
 
+void Device::uploadBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* pData, VkDeviceSize size)
+{
+    TransferBatch batch;
+    stageBuffer(batch, dstBuffer, dstOffset, pData, size);
+    submitTransfers(batch);
+}
+
+UploadToken Device::uploadBufferAsync(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* pData, VkDeviceSize size)
+{
+    TransferBatch batch;
+    batch.setAsync(true);
+    stageBuffer(batch, dstBuffer, dstOffset, pData, size);
+    return submitTransfers(batch);
+}
+
+void Device::stageBuffer(TransferBatch& batch, VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* pData, VkDeviceSize size)
+{
+    const char* pSrc = static_cast<const char*>(pData);
+    VkDeviceSize maxStaged = stagingRing->getCapacity() / 2;
+
+    //data larger than half the ring is staged in chunks, flushing the batch whenever it would exhaust the ring
+    VkDeviceSize staged = 0;
+    while (staged < size)
+    {
+        VkDeviceSize chunkSize = std::min(size - staged, maxStaged);
+
+        if (batch.getStagedBytes() + chunkSize > maxStaged)
+        {
+            submitTransfers(batch);
+        }
+
+        //flushing released the lock of the batch
+        batch.lock(*uploadMutex);
+
+        StagingRegion region = stagingRing->allocate(chunkSize, 16);
+        memcpy(region.pMapped, pSrc + staged, (size_t) chunkSize);
+
+        batch.copyBuffer(region.buffer, dstBuffer, region.offset, dstOffset + staged, chunkSize);
+        batch.addStagedBytes(chunkSize);
+
+        staged += chunkSize;
+    }
+}
+
+void Device::stageImage(TransferBatch& batch, VkImage dstImage, VkImageLayout dstLayout, const VkBufferImageCopy& region, const void* pData, VkDeviceSize size)
+{
+    VkDeviceSize maxStaged = stagingRing->getCapacity() / 2;
+    if (size > maxStaged)
+    {
+        throw std::runtime_error("Error! Image region exceeds staging capacity!");
+    }
+
+    if (batch.getStagedBytes() + size > maxStaged)
+    {
+        submitTransfers(batch);
+    }
+
+    batch.lock(*uploadMutex);
+
+    StagingRegion stagingRegion = stagingRing->allocate(size, 16);
+    memcpy(stagingRegion.pMapped, pData, (size_t) size);
+
+    VkBufferImageCopy copyRegion = region;
+    copyRegion.bufferOffset = stagingRegion.offset;
+
+    batch.copyBufferToImage(stagingRegion.buffer, dstImage, dstLayout, copyRegion);
+    batch.addStagedBytes(size);
+}
+
+UploadToken Device::submitTransfers(TransferBatch& batch)
+{
+    std::lock_guard<std::recursive_mutex> lock(*uploadMutex);
+
+    UploadToken token = {};
+
+    if (batch.empty())
+    {
+        token.serial = lastUploadSerial;
+        return token;
+    }
+
+    Queue graphicsQueue = getGraphicsQueues()[0];
+    Queue queue = graphicsQueue;
+    if (batch.isAsync() && !transferQueues.empty())
+    {
+        queue = transferQueues[0];
+    }
+
+    VkCommandPool pool = uploadPools.at(queue.family.queueFamilyIndex);
+
+    VkCommandBufferAllocateInfo commandBufferAllocInfo = {};
+    commandBufferAllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    commandBufferAllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    commandBufferAllocInfo.commandPool = pool;
+    commandBufferAllocInfo.commandBufferCount = 1;
+
+    VkCommandBuffer commandBuffer;
+    if (allocateCommandBuffers(&commandBufferAllocInfo, &commandBuffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Error! Failed to allocate transfer command buffer!");
+    }
+
+    VkCommandBufferBeginInfo commandBufferBeginInfo = {};
+    commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo);
+
+    batch.record(commandBuffer);
+
+    VkSemaphore signalSemaphore = VK_NULL_HANDLE;
+    PendingAcquire acquire = {};
+
+    if (!batch.isAsync())
+    {
+        //make the copies visible to every later submission on this queue
+        VkMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+    else
+    {
+        uint32_t srcFamily = queue.family.queueFamilyIndex;
+        uint32_t dstFamily = graphicsQueue.family.queueFamilyIndex;
+
+        signalSemaphore = stagingRing->acquireSemaphore();
+        acquire.semaphore = signalSemaphore;
+
+        //release half of the queue family ownership transfers, acquireUpload() records the matching acquires
+        if (srcFamily != dstFamily)
+        {
+            for (VkBuffer dstBuffer : batch.getDstBuffers())
+            {
+                VkBufferMemoryBarrier barrier = {};
+                barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+                barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                barrier.dstAccessMask = 0;
+                barrier.srcQueueFamilyIndex = srcFamily;
+                barrier.dstQueueFamilyIndex = dstFamily;
+                barrier.buffer = dstBuffer;
+                barrier.offset = 0;
+                barrier.size = VK_WHOLE_SIZE;
+                acquire.bufferBarriers.push_back(barrier);
+            }
+
+            for (const auto& dstImage : batch.getDstImages())
+            {
+                VkImageMemoryBarrier barrier = {};
+                barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                barrier.dstAccessMask = 0;
+                barrier.oldLayout = dstImage.layout;
+                barrier.newLayout = dstImage.layout;
+                barrier.srcQueueFamilyIndex = srcFamily;
+                barrier.dstQueueFamilyIndex = dstFamily;
+                barrier.image = dstImage.image;
+                barrier.subresourceRange.aspectMask = dstImage.aspectMask;
+                barrier.subresourceRange.baseMipLevel = 0;
+                barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+                barrier.subresourceRange.baseArrayLayer = 0;
+                barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+                acquire.imageBarriers.push_back(barrier);
+            }
+
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
+                static_cast<uint32_t>(acquire.bufferBarriers.size()), acquire.bufferBarriers.data(),
+                static_cast<uint32_t>(acquire.imageBarriers.size()), acquire.imageBarriers.data());
+
+            for (auto& barrier : acquire.bufferBarriers)
+            {
+                barrier.srcAccessMask = 0;
+                barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+            }
+            for (auto& barrier : acquire.imageBarriers)
+            {
+                barrier.srcAccessMask = 0;
+                barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+            }
+        }
+    }
+
+    vkEndCommandBuffer(commandBuffer);
+
+    VkFence fence = stagingRing->acquireFence();
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+
+    if (signalSemaphore != VK_NULL_HANDLE)
+    {
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &signalSemaphore;
+    }
+
+    if (queueSubmit(queue.queue, 1, &submitInfo, fence) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Error! Failed to submit transfers!");
+    }
+
+    lastUploadSerial = stagingRing->submit(fence, pool, commandBuffer, {});
+
+    if (signalSemaphore != VK_NULL_HANDLE)
+    {
+        acquire.serial = lastUploadSerial;
+        pendingAcquires.push_back(acquire);
+    }
+
+    batch.clear();
+    batch.unlock();
+
+    token.serial = lastUploadSerial;
+    return token;
+}
+
+bool Device::isUploadComplete(UploadToken token)
+{
+    //reclaiming frees command buffers of the upload pools
+    std::lock_guard<std::recursive_mutex> lock(*uploadMutex);
+
+    return stagingRing->getCompletedSerial() >= token.serial;
+}
+
+void Device::waitForUpload(UploadToken token)
+{
+    std::lock_guard<std::recursive_mutex> lock(*uploadMutex);
+
+    stagingRing->waitForSerial(token.serial);
+}
+
+void Device::acquireUpload(UploadToken token)
+{
+    std::lock_guard<std::recursive_mutex> lock(*uploadMutex);
+
+    std::vector<VkSemaphore> waitSemaphores;
+    std::vector<VkPipelineStageFlags> waitStages;
+    std::vector<VkBufferMemoryBarrier> bufferBarriers;
+    std::vector<VkImageMemoryBarrier> imageBarriers;
+
+    for (auto it = pendingAcquires.begin(); it != pendingAcquires.end();)
+    {
+        if (it->serial > token.serial)
+        {
+            ++it;
+            continue;
+        }
+
+        waitSemaphores.push_back(it->semaphore);
+        waitStages.push_back(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+        bufferBarriers.insert(bufferBarriers.end(), it->bufferBarriers.begin(), it->bufferBarriers.end());
+        imageBarriers.insert(imageBarriers.end(), it->imageBarriers.begin(), it->imageBarriers.end());
+
+        it = pendingAcquires.erase(it);
+    }
+
+    if (waitSemaphores.empty())
+    {
+        return;
+    }
+
+    Queue queue = getGraphicsQueues()[0];
+    VkCommandPool pool = uploadPools.at(queue.family.queueFamilyIndex);
+
+    VkCommandBufferAllocateInfo commandBufferAllocInfo = {};
+    commandBufferAllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    commandBufferAllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    commandBufferAllocInfo.commandPool = pool;
+    commandBufferAllocInfo.commandBufferCount = 1;
+
+    VkCommandBuffer commandBuffer;
+    if (allocateCommandBuffers(&commandBufferAllocInfo, &commandBuffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Error! Failed to allocate acquire command buffer!");
+    }
+
+    VkCommandBufferBeginInfo commandBufferBeginInfo = {};
+    commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo);
+
+    if (!bufferBarriers.empty() || !imageBarriers.empty())
+    {
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr,
+            static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+            static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+    }
+
+    vkEndCommandBuffer(commandBuffer);
+
+    VkFence fence = stagingRing->acquireFence();
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+    submitInfo.pWaitSemaphores = waitSemaphores.data();
+    submitInfo.pWaitDstStageMask = waitStages.data();
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+
+    if (queueSubmit(queue.queue, 1, &submitInfo, fence) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Error! Failed to submit upload acquire!");
+    }
+
+    stagingRing->submit(fence, pool, commandBuffer, waitSemaphores);
+}
+
 void Device::destroyBuffer(VkBuffer buffer, VkAllocationCallbacks* pAllocator)
 {
     vkDestroyBuffer(device, buffer, pAllocator);
 }
 
+void Device::destroyBuffer(VkBuffer buffer, Allocation& allocation)
+{
+    vkDestroyBuffer(device, buffer, nullptr);
+    allocator->free(allocation);
+}
+
+void Device::destroyImage(VkImage image, Allocation& allocation)
+{
+    vkDestroyImage(device, image, nullptr);
+    allocator->free(allocation);
+}
+
 void Device::destroyCommandPool(VkCommandPool pool, VkAllocationCallbacks* pAllocator)
 {
     vkDestroyCommandPool(device, pool, pAllocator);
 }
 
+void Device::destroyDescriptorPool(VkDescriptorPool pool, VkAllocationCallbacks* pAllocator)
+{
+    vkDestroyDescriptorPool(device, pool, pAllocator);
+}
+
+void Device::destroyDescriptorSetLayout(VkDescriptorSetLayout layout, VkAllocationCallbacks* pAllocator)
+{
+    vkDestroyDescriptorSetLayout(device, layout, pAllocator);
+}
+
 void Device::destroyFence(VkFence fence, VkAllocationCallbacks* pAllocator)
 {
     vkDestroyFence(device, fence, nullptr);
@@ -539,8 +1187,8 @@ void Device::endSingleTimeCommands(VkCommandBuffer commandBuffer, VkCommandPool
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &commandBuffer;
 
-    vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(queue);
+    queueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+    queueWaitIdle(queue);
 
     freeCommandBuffers(pool, 1, &commandBuffer);
 }
@@ -557,14 +1205,59 @@ VkResult Device::resetFences(uint32_t fenceCount, VkFence* pFences)
 
 VkResult Device::waitIdle()
 {
+    //locks are taken in map order, so two threads waiting idle cannot deadlock
+    std::vector<std::unique_lock<std::mutex>> locks;
+    for (auto& queueMutex : *queueMutexes)
+    {
+        locks.emplace_back(queueMutex.second);
+    }
+
     return vkDeviceWaitIdle(device);
 }
 
+VkResult Device::queueSubmit(VkQueue queue, uint32_t submitCount, const VkSubmitInfo* pSubmits, VkFence fence)
+{
+    std::lock_guard<std::mutex> lock(queueMutexes->at(queue));
+
+    return vkQueueSubmit(queue, submitCount, pSubmits, fence);
+}
+
+VkResult Device::queuePresent(VkQueue queue, const VkPresentInfoKHR* pPresentInfo)
+{
+    std::lock_guard<std::mutex> lock(queueMutexes->at(queue));
+
+    return vkQueuePresentKHR(queue, pPresentInfo);
+}
+
+VkResult Device::queueWaitIdle(VkQueue queue)
+{
+    std::lock_guard<std::mutex> lock(queueMutexes->at(queue));
+
+    return vkQueueWaitIdle(queue);
+}
+
 int Device::getRating(VkSurfaceKHR& surface)
 {
     return rateDevice(physicalDevice, surface);
 }
 
+bool Device::isSurfaceSupported(VkSurfaceKHR& surface)
+{
+    if (surface == VK_NULL_HANDLE)
+    {
+        return true;
+    }
+
+    //created for headless rendering, swapchains cannot be created on it
+    if (!swapchainSupported || getPhysicalDeviceSurfaceSupport(surface) != VK_TRUE)
+    {
+        return false;
+    }
+
+    SwapchainSupportDetails swapchainDetails = getSwapchainSupportDetails(surface);
+    return !swapchainDetails.formats.empty() && !swapchainDetails.presentModes.empty();
+}
+
 void Device::getBufferMemoryRequirements(VkBuffer buffer, VkMemoryRequirements* pRequirements)
 {
     vkGetBufferMemoryRequirements(device, buffer, pRequirements);
@@ -572,8 +1265,9 @@ void Device::getBufferMemoryRequirements(VkBuffer buffer, VkMemoryRequirements*
 
 void Device::getPhysicalDeviceMemoryProperties(VkPhysicalDeviceMemoryProperties* pProperties)
 {
-    vkGetPhysicalDeviceMemoryProperties(physicalDevice, pProperties);
-}  
+    //snapshot taken once at create()
+    *pProperties = allocator->getMemoryProperties();
+}
 
 VkResult Device::getSwapchainImages(VkSwapchainKHR swapchain, uint32_t* pSwapchainImageCount, VkImage* pSwapchainImages)
 {
@@ -588,8 +1282,9 @@ std::vector<QueueFamily> Device::getQueueFamilies(VkSurfaceKHR& surface)
 
 VkBool32 Device::getPhysicalDeviceSurfaceSupport(VkSurfaceKHR& surface)
 {
+    //windows present from the second graphics queue, its family need not be family 0
     VkBool32 supported;
-    vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, 0, surface, &supported);
+    vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, graphicsQueues[1].family.queueFamilyIndex, surface, &supported);
     return supported;
 }
 
@@ -603,6 +1298,11 @@ std::vector<Queue>& Device::getGraphicsQueues()
     return graphicsQueues;
 }
 
+std::vector<Queue>& Device::getComputeQueues()
+{
+    return computeQueues;
+}
+
 VkCommandPool Device::getCommandPool(Queue queue)
 {
     uint32_t queueFamily = queue.family.queueFamilyIndex;
@@ -610,20 +1310,143 @@ VkCommandPool Device::getCommandPool(Queue queue)
     return pool;
 }
 
+VkDeviceSize Device::getMinUniformBufferOffsetAlignment()
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    return properties.limits.minUniformBufferOffsetAlignment;
+}
+
 uint32_t Device::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
 {
-    VkPhysicalDeviceMemoryProperties memProperties;
-    getPhysicalDeviceMemoryProperties(&memProperties);
+    return findMemoryType(typeFilter, properties, 0);
+}
 
-    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
+uint32_t Device::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred)
+{
+    uint32_t memoryTypeIndex = allocator->findMemoryType(typeFilter, required, preferred);
+
+    if (memoryTypeIndex == UINT32_MAX)
     {
-        if (typeFilter & (i << 1) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties)
-        {
-            return i;
-        }
+        throw std::runtime_error("Error! Failed to find suitable memory type!");
+    }
+
+    return memoryTypeIndex;
+}
+
+GpuProfiler* Device::createProfiler(uint32_t slotCount, uint32_t maxScopes)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+    //frames are recorded for the first graphics queue
+    uint32_t timestampValidBits = queueFamilies[graphicsQueues[0].family.queueFamilyIndex].timestampValidBits;
+
+    GpuProfiler* profiler = new GpuProfiler();
+    profiler->create(device, properties.limits.timestampPeriod, timestampValidBits, slotCount, maxScopes);
+
+    return profiler;
+}
+
+void Device::destroyProfiler(GpuProfiler* profiler)
+{
+    profiler->destroy();
+    delete profiler;
+}
+
+VkPipelineCache Device::getPipelineCache()
+{
+    return pipelineCache->getThreadCache();
+}
+
+ShaderLibrary* Device::getShaderLibrary()
+{
+    return shaderLibrary;
+}
+
+LayoutCache* Device::getLayoutCache()
+{
+    return layoutCache;
+}
+
+GeometryCache* Device::getGeometryCache()
+{
+    return geometryCache;
+}
+
+AllocatorStats Device::getAllocatorStats()
+{
+    return allocator->getStats();
+}
+
+PipelineCacheStats Device::getPipelineCacheStats()
+{
+    return pipelineCache->getStats();
+}
+
+std::vector<HeapBudget> Device::getMemoryBudget()
+{
+    return allocator->getBudget();
+}
+
+bool Device::isWithinBudget(VkMemoryPropertyFlags properties, VkDeviceSize size)
+{
+    uint32_t memoryTypeIndex = allocator->findMemoryType(UINT32_MAX, properties, 0);
+    if (memoryTypeIndex == UINT32_MAX)
+    {
+        return false;
     }
 
-    throw std::runtime_error("Error! Failed to find suitable memory type!");
+    HeapBudget budget = allocator->getBudget()[allocator->getHeapIndex(memoryTypeIndex)];
+
+    return budget.usage + size <= budget.budget;
+}
+
+bool Device::isExtendedDynamicStateSupported()
+{
+    return extendedDynamicStateSupported;
+}
+
+void Device::cmdSetCullMode(VkCommandBuffer commandBuffer, VkCullModeFlags cullMode)
+{
+    pfnCmdSetCullMode(commandBuffer, cullMode);
+}
+
+void Device::cmdSetFrontFace(VkCommandBuffer commandBuffer, VkFrontFace frontFace)
+{
+    pfnCmdSetFrontFace(commandBuffer, frontFace);
+}
+
+void Device::cmdSetPrimitiveTopology(VkCommandBuffer commandBuffer, VkPrimitiveTopology topology)
+{
+    pfnCmdSetPrimitiveTopology(commandBuffer, topology);
+}
+
+bool Device::isMultiDrawIndirectSupported()
+{
+    return enabledFeatures.multiDrawIndirect == VK_TRUE;
+}
+
+bool Device::isDrawIndirectFirstInstanceSupported()
+{
+    return enabledFeatures.drawIndirectFirstInstance == VK_TRUE;
+}
+
+bool Device::isDrawIndirectCountSupported()
+{
+    return drawIndirectCountSupported;
+}
+
+void Device::cmdDrawIndexedIndirectCount(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countBufferOffset, uint32_t maxDrawCount, uint32_t stride)
+{
+    pfnCmdDrawIndexedIndirectCount(commandBuffer, buffer, offset, countBuffer, countBufferOffset, maxDrawCount, stride);
 }
 
 VkResult Device::acquireNextImageKHR(VkSwapchainKHR swapchain, uint64_t timeout, VkSemaphore semaphore, VkFence fence, uint32_t* pImageIndex)
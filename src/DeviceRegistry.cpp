@@ -0,0 +1,74 @@
+#include <deviceregistry.hpp>
+
+#include <stdexcept>
+
+DeviceRegistry::DeviceRegistry()
+{
+
+}
+
+DeviceRegistry::~DeviceRegistry()
+{
+
+}
+
+void DeviceRegistry::create()
+{
+
+}
+
+void DeviceRegistry::destroy()
+{
+    for (Device* device : devices)
+    {
+        device->waitIdle();
+        device->destroy();
+        delete device;
+    }
+
+    devices.clear();
+}
+
+Device* DeviceRegistry::acquire(VkSurfaceKHR& surface)
+{
+    Device* bestDevice = nullptr;
+    int bestRating = -1;
+
+    for (Device* device : devices)
+    {
+        if (!device->isSurfaceSupported(surface))
+        {
+            continue;
+        }
+
+        int rating = device->getRating(surface);
+        if (rating > bestRating)
+        {
+            bestDevice = device;
+            bestRating = rating;
+        }
+    }
+
+    if (bestDevice != nullptr)
+    {
+        return bestDevice;
+    }
+
+    Device* device = new Device();
+    device->create(surface);
+
+    if (!device->isSurfaceSupported(surface))
+    {
+        device->destroy();
+        delete device;
+        throw std::runtime_error("Error! Surface not supported by device");
+    }
+
+    devices.push_back(device);
+    return device;
+}
+
+const std::vector<Device*>& DeviceRegistry::getDevices()
+{
+    return devices;
+}
@@ -0,0 +1,140 @@
+#include <drawlist.hpp>
+
+#include <device.hpp>
+
+#include <string.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+DrawList::DrawList()
+{
+
+}
+
+DrawList::~DrawList()
+{
+
+}
+
+void DrawList::create(Device& device, uint32_t capacity)
+{
+    this->capacity = std::max(capacity, 1u);
+    uploadedCount = 0;
+
+    createCommandBuffer(device);
+
+    device.createSharedBuffer(sizeof(uint32_t), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, countBuffer, countAllocation);
+    memset(countAllocation.pMapped, 0, sizeof(uint32_t));
+}
+
+void DrawList::destroy(Device& device)
+{
+    device.destroyBuffer(commandBuffer, commandAllocation);
+    device.destroyBuffer(countBuffer, countAllocation);
+
+    draws.clear();
+}
+
+void DrawList::clear()
+{
+    draws.clear();
+}
+
+void DrawList::addDraw(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance)
+{
+    VkDrawIndexedIndirectCommand draw = {};
+    draw.indexCount = indexCount;
+    draw.instanceCount = instanceCount;
+    draw.firstIndex = firstIndex;
+    draw.vertexOffset = vertexOffset;
+    draw.firstInstance = firstInstance;
+
+    draws.push_back(draw);
+}
+
+uint32_t DrawList::getDrawCount()
+{
+    return static_cast<uint32_t>(draws.size());
+}
+
+void DrawList::upload(Device& device)
+{
+    if (draws.size() > capacity)
+    {
+        device.destroyBuffer(commandBuffer, commandAllocation);
+
+        capacity = std::max(static_cast<uint32_t>(draws.size()), capacity * 2);
+        createCommandBuffer(device);
+    }
+
+    uploadedCount = static_cast<uint32_t>(draws.size());
+
+    memcpy(commandAllocation.pMapped, draws.data(), draws.size() * sizeof(VkDrawIndexedIndirectCommand));
+    memcpy(countAllocation.pMapped, &uploadedCount, sizeof(uint32_t));
+}
+
+void DrawList::reserve(Device& device, uint32_t drawCount)
+{
+    if (drawCount > capacity)
+    {
+        device.destroyBuffer(commandBuffer, commandAllocation);
+
+        capacity = std::max(drawCount, capacity * 2);
+        createCommandBuffer(device);
+    }
+
+    draws.clear();
+    uploadedCount = drawCount;
+}
+
+uint32_t DrawList::record(Device& device, VkCommandBuffer commandBuffer)
+{
+    if (uploadedCount == 0)
+    {
+        return 0;
+    }
+
+    const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+
+    //the count is read on the GPU, so a compute pass may shrink the list after recording
+    if (device.isDrawIndirectCountSupported())
+    {
+        device.cmdDrawIndexedIndirectCount(commandBuffer, this->commandBuffer, 0, countBuffer, 0, capacity, stride);
+        return 1;
+    }
+
+    if (device.isMultiDrawIndirectSupported())
+    {
+        vkCmdDrawIndexedIndirect(commandBuffer, this->commandBuffer, 0, uploadedCount, stride);
+        return 1;
+    }
+
+    //without multi draw indirect the draw count has to be one
+    for (uint32_t i = 0; i < uploadedCount; i++)
+    {
+        vkCmdDrawIndexedIndirect(commandBuffer, this->commandBuffer, i * stride, 1, stride);
+    }
+    return uploadedCount;
+}
+
+VkBuffer DrawList::getCommandBuffer()
+{
+    return commandBuffer;
+}
+
+VkBuffer DrawList::getCountBuffer()
+{
+    return countBuffer;
+}
+
+uint32_t DrawList::getCapacity()
+{
+    return capacity;
+}
+
+void DrawList::createCommandBuffer(Device& device)
+{
+    VkDeviceSize size = capacity * sizeof(VkDrawIndexedIndirectCommand);
+    device.createSharedBuffer(size, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, commandBuffer, commandAllocation);
+}
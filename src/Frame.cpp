@@ -0,0 +1,133 @@
+#include <frame.hpp>
+
+#include <device.hpp>
+
+#include <stdexcept>
+
+//one pool holds the sets of a typical frame, further pools are added when a frame needs more
+const uint32_t DESCRIPTOR_POOL_MAX_SETS = 256;
+const std::vector<VkDescriptorPoolSize> DESCRIPTOR_POOL_SIZES = {
+    {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 256},
+    {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 128},
+    {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 128},
+    {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 256}};
+
+FrameContext::FrameContext()
+{
+
+}
+
+FrameContext::~FrameContext()
+{
+
+}
+
+void FrameContext::create(Device& device, uint32_t queueFamilyIndex, uint32_t threadCount)
+{
+    threadPools.resize(threadCount);
+
+    for (auto& threadPool : threadPools)
+    {
+        VkCommandPoolCreateInfo poolCreateInfo = {};
+        poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolCreateInfo.queueFamilyIndex = queueFamilyIndex;
+        poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+        if (device.createCommandPool(&poolCreateInfo, nullptr, &threadPool.pool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Error! Failed to create frame command pool!");
+        }
+
+        threadPool.primaryUsed = 0;
+        threadPool.secondaryUsed = 0;
+    }
+
+    descriptorAllocators.resize(threadCount);
+    for (auto& descriptorAllocator : descriptorAllocators)
+    {
+        descriptorAllocator.create(DESCRIPTOR_POOL_SIZES, DESCRIPTOR_POOL_MAX_SETS);
+    }
+}
+
+void FrameContext::destroy(Device& device)
+{
+    //destroying a pool frees its command buffers
+    for (auto& threadPool : threadPools)
+    {
+        device.destroyCommandPool(threadPool.pool, nullptr);
+    }
+
+    for (auto& descriptorAllocator : descriptorAllocators)
+    {
+        descriptorAllocator.destroy(device);
+    }
+
+    threadPools.clear();
+    descriptorAllocators.clear();
+}
+
+void FrameContext::reset(Device& device)
+{
+    for (auto& threadPool : threadPools)
+    {
+        if (device.resetCommandPool(threadPool.pool, 0) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Error! Failed to reset frame command pool!");
+        }
+
+        threadPool.primaryUsed = 0;
+        threadPool.secondaryUsed = 0;
+    }
+
+    for (auto& descriptorAllocator : descriptorAllocators)
+    {
+        descriptorAllocator.reset(device);
+    }
+}
+
+VkCommandBuffer FrameContext::getPrimaryBuffer(Device& device, uint32_t thread)
+{
+    return getBuffer(device, threadPools[thread], VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+}
+
+VkCommandBuffer FrameContext::getSecondaryBuffer(Device& device, uint32_t thread)
+{
+    return getBuffer(device, threadPools[thread], VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+}
+
+VkDescriptorSet FrameContext::allocateDescriptorSet(Device& device, uint32_t thread, VkDescriptorSetLayout layout)
+{
+    return descriptorAllocators[thread].allocate(device, layout);
+}
+
+uint32_t FrameContext::getThreadCount()
+{
+    return static_cast<uint32_t>(threadPools.size());
+}
+
+VkCommandBuffer FrameContext::getBuffer(Device& device, ThreadCommandPool& threadPool, VkCommandBufferLevel level)
+{
+    bool primary = level == VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+
+    std::vector<VkCommandBuffer>& buffers = primary ? threadPool.primaryBuffers : threadPool.secondaryBuffers;
+    uint32_t& used = primary ? threadPool.primaryUsed : threadPool.secondaryUsed;
+
+    if (used == buffers.size())
+    {
+        VkCommandBufferAllocateInfo allocInfo = {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = threadPool.pool;
+        allocInfo.level = level;
+        allocInfo.commandBufferCount = 1;
+
+        VkCommandBuffer commandBuffer;
+        if (device.allocateCommandBuffers(&allocInfo, &commandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Error! Failed to allocate frame command buffer!");
+        }
+
+        buffers.push_back(commandBuffer);
+    }
+
+    return buffers[used++];
+}
@@ -0,0 +1,99 @@
+#include <geometrycache.hpp>
+
+#include <iostream>
+#include <stdexcept>
+
+GeometryCache::GeometryCache()
+{
+
+}
+
+GeometryCache::~GeometryCache()
+{
+
+}
+
+void GeometryCache::create()
+{
+    createdCount = 0;
+    reusedCount = 0;
+}
+
+void GeometryCache::destroy(Device& device)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (auto& entry : entries)
+    {
+        if (entry.second.refCount > 0)
+        {
+            std::cout << "Warning! Geometry '" << entry.first << "' destroyed with " << entry.second.refCount << " references left" << std::endl;
+        }
+
+        device.destroyBuffer(entry.second.buffers.vertexBuffer, entry.second.buffers.vertexBufferAllocation);
+        device.destroyBuffer(entry.second.buffers.indexBuffer, entry.second.buffers.indexBufferAllocation);
+    }
+
+    entries.clear();
+    keys.clear();
+}
+
+GeometryBuffers GeometryCache::acquire(const std::string& key, const std::function<GeometryBuffers()>& create)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = entries.find(key);
+    if (it != entries.end())
+    {
+        it->second.refCount++;
+        reusedCount++;
+        return it->second.buffers;
+    }
+
+    GeometryEntry entry = {};
+    entry.buffers = create();
+    entry.refCount = 1;
+
+    entries[key] = entry;
+    keys[entry.buffers.vertexBuffer] = key;
+    createdCount++;
+
+    return entry.buffers;
+}
+
+void GeometryCache::release(Device& device, VkBuffer vertexBuffer)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto keyIt = keys.find(vertexBuffer);
+    if (keyIt == keys.end())
+    {
+        throw std::runtime_error("Error! Released geometry is not part of the cache!");
+    }
+
+    auto entryIt = entries.find(keyIt->second);
+    GeometryEntry& entry = entryIt->second;
+
+    if (--entry.refCount > 0)
+    {
+        return;
+    }
+
+    //the caller waited for the device to idle, no frame reads the buffers anymore
+    device.destroyBuffer(entry.buffers.vertexBuffer, entry.buffers.vertexBufferAllocation);
+    device.destroyBuffer(entry.buffers.indexBuffer, entry.buffers.indexBufferAllocation);
+
+    keys.erase(keyIt);
+    entries.erase(entryIt);
+}
+
+GeometryCacheStats GeometryCache::getStats()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    GeometryCacheStats stats = {};
+    stats.meshCount = static_cast<uint32_t>(entries.size());
+    stats.createdCount = createdCount;
+    stats.reusedCount = reusedCount;
+    return stats;
+}
@@ -0,0 +1,180 @@
+#include <layoutcache.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+LayoutCache::LayoutCache()
+{
+
+}
+
+LayoutCache::~LayoutCache()
+{
+
+}
+
+void LayoutCache::create(VkDevice device)
+{
+    this->device = device;
+}
+
+void LayoutCache::destroy()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (auto& pipelineLayout : pipelineLayouts)
+    {
+        vkDestroyPipelineLayout(device, pipelineLayout.second, nullptr);
+    }
+
+    for (auto& setLayout : setLayouts)
+    {
+        vkDestroyDescriptorSetLayout(device, setLayout.second, nullptr);
+    }
+
+    pipelineLayouts.clear();
+    setLayouts.clear();
+}
+
+VkDescriptorSetLayout LayoutCache::getSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    return getSetLayoutLocked(bindings);
+}
+
+PipelineLayoutInfo LayoutCache::getPipelineLayout(const std::vector<ShaderReflection>& stages, bool dynamicUniformBuffers)
+{
+    PipelineLayoutInfo info = {};
+
+    VkPushConstantRange pushConstantRange = {};
+    for (const auto& stage : stages)
+    {
+        for (auto binding : stage.bindings)
+        {
+            if (dynamicUniformBuffers && binding.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+            {
+                binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            }
+
+            if (binding.set >= info.setBindings.size())
+            {
+                info.setBindings.resize(binding.set + 1);
+            }
+
+            std::vector<VkDescriptorSetLayoutBinding>& setBindings = info.setBindings[binding.set];
+            auto it = std::find_if(setBindings.begin(), setBindings.end(), [&binding](const VkDescriptorSetLayoutBinding& setBinding) {
+                return setBinding.binding == binding.binding;
+            });
+
+            if (it == setBindings.end())
+            {
+                VkDescriptorSetLayoutBinding setBinding = {};
+                setBinding.binding = binding.binding;
+                setBinding.descriptorType = binding.descriptorType;
+                setBinding.descriptorCount = binding.descriptorCount;
+                setBinding.stageFlags = stage.stage;
+                setBindings.push_back(setBinding);
+            }
+            else if (it->descriptorType != binding.descriptorType || it->descriptorCount != binding.descriptorCount)
+            {
+                throw std::runtime_error("Error! Shader stages disagree on descriptor '" + binding.name + "'!");
+            }
+            else
+            {
+                it->stageFlags |= stage.stage;
+            }
+        }
+
+        if (stage.pushConstantSize > 0)
+        {
+            pushConstantRange.size = std::max(pushConstantRange.size, stage.pushConstantSize);
+            pushConstantRange.stageFlags |= stage.stage;
+        }
+    }
+
+    if (pushConstantRange.size > 0)
+    {
+        info.pushConstantRanges.push_back(pushConstantRange);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (const auto& setBindings : info.setBindings)
+    {
+        info.setLayouts.push_back(getSetLayoutLocked(setBindings));
+    }
+
+    PipelineLayoutKey key;
+    key.first = info.setLayouts;
+    for (const auto& range : info.pushConstantRanges)
+    {
+        key.second.push_back({range.offset, range.size, range.stageFlags});
+    }
+
+    auto it = pipelineLayouts.find(key);
+    if (it != pipelineLayouts.end())
+    {
+        info.layout = it->second;
+        return info;
+    }
+
+    VkPipelineLayoutCreateInfo layoutCreateInfo = {};
+    layoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutCreateInfo.setLayoutCount = static_cast<uint32_t>(info.setLayouts.size());
+    layoutCreateInfo.pSetLayouts = info.setLayouts.data();
+    layoutCreateInfo.pushConstantRangeCount = static_cast<uint32_t>(info.pushConstantRanges.size());
+    layoutCreateInfo.pPushConstantRanges = info.pushConstantRanges.data();
+
+    if (vkCreatePipelineLayout(device, &layoutCreateInfo, nullptr, &info.layout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Error! Failed to create pipeline layout!");
+    }
+
+    pipelineLayouts[key] = info.layout;
+    return info;
+}
+
+LayoutCacheStats LayoutCache::getStats()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    LayoutCacheStats stats = {};
+    stats.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+    stats.pipelineLayoutCount = static_cast<uint32_t>(pipelineLayouts.size());
+    return stats;
+}
+
+VkDescriptorSetLayout LayoutCache::getSetLayoutLocked(const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+{
+    SetLayoutKey key;
+    for (const auto& binding : bindings)
+    {
+        if (binding.pImmutableSamplers != nullptr)
+        {
+            throw std::runtime_error("Error! Immutable samplers are not supported by the layout cache!");
+        }
+        key.push_back({binding.binding, static_cast<uint32_t>(binding.descriptorType), binding.descriptorCount, binding.stageFlags});
+    }
+    std::sort(key.begin(), key.end());
+
+    auto it = setLayouts.find(key);
+    if (it != setLayouts.end())
+    {
+        return it->second;
+    }
+
+    VkDescriptorSetLayoutCreateInfo setLayoutCreateInfo = {};
+    setLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    setLayoutCreateInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    setLayoutCreateInfo.pBindings = bindings.data();
+
+    VkDescriptorSetLayout setLayout;
+    if (vkCreateDescriptorSetLayout(device, &setLayoutCreateInfo, nullptr, &setLayout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Error! Failed to create descriptor set layout!");
+    }
+
+    setLayouts[key] = setLayout;
+    return setLayout;
+}
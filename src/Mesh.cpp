@@ -0,0 +1,387 @@
+#include <mesh.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+//Forsyth scoring constants, as published
+const float CACHE_DECAY_POWER = 1.5f;
+const float LAST_TRIANGLE_SCORE = 0.75f;
+const float VALENCE_BOOST_SCALE = 2.0f;
+const float VALENCE_BOOST_POWER = 0.5f;
+
+MeshStats analyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize)
+{
+    MeshStats stats = {};
+    stats.triangleCount = static_cast<uint32_t>(indices.size() / 3);
+
+    //time stamps instead of an explicit queue, a vertex is cached if it entered within the last 'cacheSize' misses
+    std::vector<uint32_t> cacheTimes(vertexCount, 0);
+    std::vector<bool> referenced(vertexCount, false);
+    uint32_t time = cacheSize + 1;
+
+    for (uint32_t index : indices)
+    {
+        if (!referenced[index])
+        {
+            referenced[index] = true;
+            stats.vertexCount++;
+        }
+
+        if (time - cacheTimes[index] > cacheSize)
+        {
+            cacheTimes[index] = time++;
+            stats.cacheMisses++;
+        }
+    }
+
+    stats.acmr = stats.triangleCount == 0 ? 0.0f : static_cast<float>(stats.cacheMisses) / stats.triangleCount;
+    stats.atvr = stats.vertexCount == 0 ? 0.0f : static_cast<float>(stats.cacheMisses) / stats.vertexCount;
+
+    return stats;
+}
+
+uint32_t deduplicateVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+    if (indices.empty())
+    {
+        indices.resize(vertices.size());
+        std::iota(indices.begin(), indices.end(), 0);
+    }
+
+    std::unordered_map<Vertex, uint32_t, VertexHash> uniqueIndices;
+    uniqueIndices.reserve(vertices.size());
+
+    std::vector<Vertex> uniqueVertices;
+    std::vector<uint32_t> remap(vertices.size());
+
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        auto result = uniqueIndices.insert(std::make_pair(vertices[i], static_cast<uint32_t>(uniqueVertices.size())));
+        if (result.second)
+        {
+            uniqueVertices.push_back(vertices[i]);
+        }
+
+        remap[i] = result.first->second;
+    }
+
+    for (uint32_t& index : indices)
+    {
+        index = remap[index];
+    }
+
+    vertices.swap(uniqueVertices);
+
+    return static_cast<uint32_t>(vertices.size());
+}
+
+float vertexScore(int cachePosition, uint32_t remainingValence, uint32_t cacheSize)
+{
+    //vertices without remaining triangles must never attract the next pick
+    if (remainingValence == 0)
+    {
+        return -1.0f;
+    }
+
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        //the last triangle's vertices get a fixed score so its direct neighbours are not always preferred
+        if (cachePosition < 3)
+        {
+            score = LAST_TRIANGLE_SCORE;
+        }
+        else
+        {
+            float scaler = 1.0f / (cacheSize - 3);
+            score = std::pow(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+        }
+    }
+
+    //boost vertices with few triangles left so lone triangles are not left behind
+    score += VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingValence), -VALENCE_BOOST_POWER);
+
+    return score;
+}
+
+void optimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize)
+{
+    uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    //triangles adjacent to each vertex, packed; the first 'valence' entries are the ones not yet emitted
+    std::vector<uint32_t> valence(vertexCount, 0);
+    for (uint32_t index : indices)
+    {
+        valence[index]++;
+    }
+
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (uint32_t i = 0; i < vertexCount; i++)
+    {
+        adjacencyOffsets[i + 1] = adjacencyOffsets[i] + valence[i];
+    }
+
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (uint32_t i = 0; i < triangleCount; i++)
+    {
+        for (uint32_t j = 0; j < 3; j++)
+        {
+            adjacency[fill[indices[i * 3 + j]]++] = i;
+        }
+    }
+
+    std::vector<int> cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (uint32_t i = 0; i < vertexCount; i++)
+    {
+        vertexScores[i] = vertexScore(-1, valence[i], cacheSize);
+    }
+
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    for (uint32_t i = 0; i < triangleCount; i++)
+    {
+        triangleScores[i] = vertexScores[indices[i * 3]] + vertexScores[indices[i * 3 + 1]] + vertexScores[indices[i * 3 + 2]];
+    }
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> newCache;
+    cache.reserve(cacheSize + 3);
+    newCache.reserve(cacheSize + 3);
+
+    uint32_t bestTriangle = static_cast<uint32_t>(std::max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin());
+    uint32_t scanCursor = 0;
+
+    for (uint32_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+    {
+        //nothing in the cache has triangles left, continue with the next unemitted one in input order
+        if (bestTriangle == UINT32_MAX)
+        {
+            while (emitted[scanCursor])
+            {
+                scanCursor++;
+            }
+            bestTriangle = scanCursor;
+        }
+
+        emitted[bestTriangle] = true;
+
+        const uint32_t* triangle = &indices[bestTriangle * 3];
+        output.insert(output.end(), triangle, triangle + 3);
+
+        newCache.assign(triangle, triangle + 3);
+        for (uint32_t j = 0; j < 3; j++)
+        {
+            uint32_t vertex = triangle[j];
+
+            //swap the emitted triangle out of the vertex's remaining range
+            uint32_t* pBegin = &adjacency[adjacencyOffsets[vertex]];
+            uint32_t* pEnd = pBegin + valence[vertex];
+            *std::find(pBegin, pEnd, bestTriangle) = *(pEnd - 1);
+            valence[vertex]--;
+        }
+
+        for (uint32_t vertex : cache)
+        {
+            if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+            {
+                newCache.push_back(vertex);
+            }
+        }
+
+        //update every vertex that moved, including those pushed out of the cache
+        for (uint32_t i = 0; i < newCache.size(); i++)
+        {
+            uint32_t vertex = newCache[i];
+            cachePositions[vertex] = i < cacheSize ? static_cast<int>(i) : -1;
+            vertexScores[vertex] = vertexScore(cachePositions[vertex], valence[vertex], cacheSize);
+        }
+
+        bestTriangle = UINT32_MAX;
+        float bestScore = -1.0f;
+
+        for (uint32_t vertex : newCache)
+        {
+            for (uint32_t k = 0; k < valence[vertex]; k++)
+            {
+                uint32_t t = adjacency[adjacencyOffsets[vertex] + k];
+
+                float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+                triangleScores[t] = score;
+
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    bestTriangle = t;
+                }
+            }
+        }
+
+        if (newCache.size() > cacheSize)
+        {
+            newCache.resize(cacheSize);
+        }
+        cache.swap(newCache);
+    }
+
+    indices.swap(output);
+}
+
+void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<glm::vec3>& positions, float threshold, uint32_t cacheSize)
+{
+    uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    uint32_t vertexCount = static_cast<uint32_t>(positions.size());
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    //split where a triangle misses on all three vertices, the cache is cold there anyway
+    std::vector<uint32_t> clusterStarts;
+    std::vector<uint32_t> cacheTimes(vertexCount, 0);
+    uint32_t time = cacheSize + 1;
+
+    for (uint32_t i = 0; i < triangleCount; i++)
+    {
+        uint32_t misses = 0;
+        for (uint32_t j = 0; j < 3; j++)
+        {
+            uint32_t index = indices[i * 3 + j];
+            if (time - cacheTimes[index] > cacheSize)
+            {
+                cacheTimes[index] = time++;
+                misses++;
+            }
+        }
+
+        if (i == 0 || misses == 3)
+        {
+            clusterStarts.push_back(i);
+        }
+    }
+    clusterStarts.push_back(triangleCount);
+
+    uint32_t clusterCount = static_cast<uint32_t>(clusterStarts.size() - 1);
+    if (clusterCount < 2)
+    {
+        return;
+    }
+
+    glm::vec3 meshCentroid(0.0f);
+    for (const auto& position : positions)
+    {
+        meshCentroid += position;
+    }
+    meshCentroid = meshCentroid / static_cast<float>(vertexCount);
+
+    //clusters facing away from the centre occlude the rest, so they are drawn first
+    std::vector<float> sortKeys(clusterCount);
+    for (uint32_t c = 0; c < clusterCount; c++)
+    {
+        glm::vec3 centroid(0.0f);
+        glm::vec3 normal(0.0f);
+        float area = 0.0f;
+
+        for (uint32_t i = clusterStarts[c]; i < clusterStarts[c + 1]; i++)
+        {
+            const glm::vec3& p0 = positions[indices[i * 3]];
+            const glm::vec3& p1 = positions[indices[i * 3 + 1]];
+            const glm::vec3& p2 = positions[indices[i * 3 + 2]];
+
+            glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+            float a = glm::length(n);
+
+            centroid += (p0 + p1 + p2) * (a / 3.0f);
+            normal += n;
+            area += a;
+        }
+
+        float normalLength = glm::length(normal);
+        if (area == 0.0f || normalLength == 0.0f)
+        {
+            sortKeys[c] = 0.0f;
+            continue;
+        }
+
+        centroid = centroid / area;
+        normal = normal / normalLength;
+
+        sortKeys[c] = glm::dot(centroid - meshCentroid, normal);
+    }
+
+    std::vector<uint32_t> clusterOrder(clusterCount);
+    std::iota(clusterOrder.begin(), clusterOrder.end(), 0);
+    std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&](uint32_t a, uint32_t b) {
+        return sortKeys[a] > sortKeys[b];
+    });
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    for (uint32_t c : clusterOrder)
+    {
+        output.insert(output.end(), indices.begin() + clusterStarts[c] * 3, indices.begin() + clusterStarts[c + 1] * 3);
+    }
+
+    float acmrBefore = analyzeVertexCache(indices, vertexCount, cacheSize).acmr;
+    float acmrAfter = analyzeVertexCache(output, vertexCount, cacheSize).acmr;
+
+    if (acmrAfter <= acmrBefore * threshold)
+    {
+        indices.swap(output);
+    }
+}
+
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+    std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+    std::vector<Vertex> ordered;
+    ordered.reserve(vertices.size());
+
+    for (uint32_t& index : indices)
+    {
+        if (remap[index] == UINT32_MAX)
+        {
+            remap[index] = static_cast<uint32_t>(ordered.size());
+            ordered.push_back(vertices[index]);
+        }
+
+        index = remap[index];
+    }
+
+    vertices.swap(ordered);
+}
+
+MeshReport optimizeMesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, bool overdraw)
+{
+    MeshReport report = {};
+
+    if (indices.empty())
+    {
+        indices.resize(vertices.size());
+        std::iota(indices.begin(), indices.end(), 0);
+    }
+
+    report.before = analyzeVertexCache(indices, static_cast<uint32_t>(vertices.size()));
+
+    deduplicateVertices(vertices, indices);
+    optimizeVertexCache(indices, static_cast<uint32_t>(vertices.size()));
+
+    //flat meshes give every cluster a sort key of zero, run optimizeOverdraw() once Vertex gains a z coordinate
+    (void) overdraw;
+
+    optimizeVertexFetch(vertices, indices);
+
+    report.after = analyzeVertexCache(indices, static_cast<uint32_t>(vertices.size()));
+
+    return report;
+}
@@ -0,0 +1,357 @@
+#include <meshfile.hpp>
+
+#include <string.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+MeshFile::MeshFile()
+{
+    pMapped = nullptr;
+    mappedSize = 0;
+    mapped = false;
+}
+
+MeshFile::~MeshFile()
+{
+
+}
+
+void MeshFile::create(const std::string& path)
+{
+    pMapped = nullptr;
+    mappedSize = 0;
+    mapped = true;
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Error! Failed to open mesh file: " + path);
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || static_cast<size_t>(fileStat.st_size) < sizeof(MeshFileHeader))
+    {
+        close(fd);
+        throw std::runtime_error("Error! Mesh file is truncated: " + path);
+    }
+
+    mappedSize = static_cast<size_t>(fileStat.st_size);
+
+    void* pData = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    //the mapping keeps its own reference to the file
+    close(fd);
+
+    if (pData == MAP_FAILED)
+    {
+        throw std::runtime_error("Error! Failed to map mesh file: " + path);
+    }
+
+    pMapped = static_cast<const uint8_t*>(pData);
+
+    //streams are read front to back exactly once while staging
+    madvise(pData, mappedSize, MADV_SEQUENTIAL);
+
+    validate(path);
+}
+
+void MeshFile::create(std::vector<char>& data, const std::string& path)
+{
+    mapped = false;
+    contents.swap(data);
+
+    pMapped = reinterpret_cast<const uint8_t*>(contents.data());
+    mappedSize = contents.size();
+
+    if (mappedSize < sizeof(MeshFileHeader))
+    {
+        destroy();
+        throw std::runtime_error("Error! Mesh file is truncated: " + path);
+    }
+
+    validate(path);
+}
+
+void MeshFile::destroy()
+{
+    if (pMapped != nullptr && mapped)
+    {
+        munmap(const_cast<uint8_t*>(pMapped), mappedSize);
+    }
+
+    pMapped = nullptr;
+    contents.clear();
+    contents.shrink_to_fit();
+}
+
+const MeshFileHeader& MeshFile::getHeader()
+{
+    return header;
+}
+
+VertexFormat MeshFile::getVertexFormat()
+{
+    return static_cast<VertexFormat>(header.vertexFormat);
+}
+
+VkIndexType MeshFile::getIndexType()
+{
+    return header.indexSize == 2 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+}
+
+const void* MeshFile::getVertexData()
+{
+    return pMapped + header.vertexOffset;
+}
+
+VkDeviceSize MeshFile::getVertexDataSize()
+{
+    return static_cast<VkDeviceSize>(header.vertexStride) * header.vertexCount;
+}
+
+const void* MeshFile::getIndexData()
+{
+    return pMapped + header.indexOffset;
+}
+
+VkDeviceSize MeshFile::getIndexDataSize()
+{
+    return static_cast<VkDeviceSize>(header.indexSize) * header.indexCount;
+}
+
+void MeshFile::validate(const std::string& path)
+{
+    memcpy(&header, pMapped, sizeof(header));
+
+    uint64_t vertexSize = static_cast<uint64_t>(header.vertexStride) * header.vertexCount;
+    uint64_t indexSize = static_cast<uint64_t>(header.indexSize) * header.indexCount;
+
+    bool valid = header.magic == MESH_FILE_MAGIC
+        && header.version == MESH_FILE_VERSION
+        && header.vertexFormat <= VERTEX_FORMAT_SNORM16
+        && header.vertexStride == getVertexStride(static_cast<VertexFormat>(header.vertexFormat))
+        && (header.indexSize == 2 || header.indexSize == 4)
+        && header.vertexOffset % MESH_FILE_ALIGNMENT == 0
+        && header.indexOffset % MESH_FILE_ALIGNMENT == 0
+        //written so offsets near 2^64 cannot wrap around the size check
+        && header.vertexOffset >= sizeof(header) && header.vertexOffset <= mappedSize && vertexSize <= mappedSize - header.vertexOffset
+        && header.indexOffset >= sizeof(header) && header.indexOffset <= mappedSize && indexSize <= mappedSize - header.indexOffset;
+
+    if (!valid)
+    {
+        destroy();
+        throw std::runtime_error("Error! Invalid mesh file: " + path);
+    }
+
+    //an index past the last vertex would make the GPU fetch outside the vertex buffer
+    uint32_t maxIndex = 0;
+    if (header.indexSize == 2)
+    {
+        const uint16_t* pIndices = reinterpret_cast<const uint16_t*>(pMapped + header.indexOffset);
+        for (uint32_t i = 0; i < header.indexCount; i++)
+        {
+            maxIndex = std::max<uint32_t>(maxIndex, pIndices[i]);
+        }
+    }
+    else
+    {
+        const uint32_t* pIndices = reinterpret_cast<const uint32_t*>(pMapped + header.indexOffset);
+        for (uint32_t i = 0; i < header.indexCount; i++)
+        {
+            maxIndex = std::max(maxIndex, pIndices[i]);
+        }
+    }
+
+    if (header.indexCount > 0 && maxIndex >= header.vertexCount)
+    {
+        destroy();
+        throw std::runtime_error("Error! Mesh file index out of range: " + path);
+    }
+}
+
+uint64_t alignOffset(uint64_t offset)
+{
+    return (offset + MESH_FILE_ALIGNMENT - 1) / MESH_FILE_ALIGNMENT * MESH_FILE_ALIGNMENT;
+}
+
+void writeMeshFile(const std::string& path, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, VertexFormat format)
+{
+    std::vector<uint8_t> packedVertices = packVertices(vertices, format);
+
+    MeshFileHeader header = {};
+    header.magic = MESH_FILE_MAGIC;
+    header.version = MESH_FILE_VERSION;
+    header.vertexFormat = format;
+    header.vertexStride = getVertexStride(format);
+    header.vertexCount = static_cast<uint32_t>(vertices.size());
+    header.indexSize = vertices.size() <= 65536 ? 2 : 4;
+    header.indexCount = static_cast<uint32_t>(indices.size());
+    header.vertexOffset = alignOffset(sizeof(header));
+    header.indexOffset = alignOffset(header.vertexOffset + packedVertices.size());
+
+    for (int i = 0; i < 3; i++)
+    {
+        header.boundsMin[i] = vertices.empty() ? 0.0f : INFINITY;
+        header.boundsMax[i] = vertices.empty() ? 0.0f : -INFINITY;
+    }
+
+    //positions are two dimensional, z stays zero
+    for (const auto& vertex : vertices)
+    {
+        for (int i = 0; i < 2; i++)
+        {
+            header.boundsMin[i] = std::min(header.boundsMin[i], vertex.pos[i]);
+            header.boundsMax[i] = std::max(header.boundsMax[i], vertex.pos[i]);
+        }
+        header.radius = std::max(header.radius, glm::length(vertex.pos));
+    }
+    if (!vertices.empty())
+    {
+        header.boundsMin[2] = 0.0f;
+        header.boundsMax[2] = 0.0f;
+    }
+
+    std::vector<uint8_t> indexData(static_cast<size_t>(header.indexSize) * indices.size());
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        if (header.indexSize == 2)
+        {
+            uint16_t index = static_cast<uint16_t>(indices[i]);
+            memcpy(&indexData[i * 2], &index, sizeof(index));
+        }
+        else
+        {
+            memcpy(&indexData[i * 4], &indices[i], sizeof(indices[i]));
+        }
+    }
+
+    std::vector<uint8_t> data(static_cast<size_t>(header.indexOffset) + indexData.size(), 0);
+    memcpy(data.data(), &header, sizeof(header));
+    memcpy(data.data() + header.vertexOffset, packedVertices.data(), packedVertices.size());
+    memcpy(data.data() + header.indexOffset, indexData.data(), indexData.size());
+
+    std::string tempPath = path + ".tmp";
+
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Error! Failed to write mesh file: " + tempPath);
+    }
+
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    file.close();
+
+    if (file.fail() || rename(tempPath.c_str(), path.c_str()) != 0)
+    {
+        remove(tempPath.c_str());
+        throw std::runtime_error("Error! Failed to replace mesh file: " + path);
+    }
+}
+
+void loadObjFile(const std::string& path, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Error! Failed to open OBJ file: " + path);
+    }
+
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+
+    vertices.clear();
+    indices.clear();
+
+    std::vector<uint32_t> face;
+
+    const char* p = text.c_str();
+    while (*p != '\0')
+    {
+        const char* pLineEnd = p + strcspn(p, "\r\n");
+
+        if (p[0] == 'v' && (p[1] == ' ' || p[1] == '\t'))
+        {
+            char* pNext = const_cast<char*>(p + 2);
+
+            float values[6] = {0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f};
+            int valueCount = 0;
+            while (valueCount < 6 && pNext < pLineEnd)
+            {
+                char* pEnd;
+                float value = strtof(pNext, &pEnd);
+                if (pEnd == pNext || pEnd > pLineEnd)
+                {
+                    break;
+                }
+
+                values[valueCount++] = value;
+                pNext = pEnd;
+            }
+
+            //a position without color keeps the default white
+            if (valueCount < 6)
+            {
+                values[3] = values[4] = values[5] = 1.0f;
+            }
+
+            Vertex vertex = {};
+            vertex.pos = glm::vec2(values[0], values[1]);
+            vertex.color = glm::vec3(values[3], values[4], values[5]);
+            vertices.push_back(vertex);
+        }
+        else if (p[0] == 'f' && (p[1] == ' ' || p[1] == '\t'))
+        {
+            char* pNext = const_cast<char*>(p + 2);
+
+            face.clear();
+            while (pNext < pLineEnd)
+            {
+                char* pEnd;
+                long index = strtol(pNext, &pEnd, 10);
+                if (pEnd == pNext || pEnd > pLineEnd)
+                {
+                    break;
+                }
+
+                //negative indices count back from the last vertex read so far
+                long resolved = index < 0 ? static_cast<long>(vertices.size()) + index : index - 1;
+                if (resolved < 0 || resolved >= static_cast<long>(vertices.size()))
+                {
+                    throw std::runtime_error("Error! OBJ face references a missing vertex: " + path);
+                }
+                face.push_back(static_cast<uint32_t>(resolved));
+
+                //skip texture coordinate and normal indices
+                pNext = pEnd;
+                while (pNext < pLineEnd && *pNext != ' ' && *pNext != '\t')
+                {
+                    pNext++;
+                }
+            }
+
+            for (size_t i = 2; i < face.size(); i++)
+            {
+                indices.push_back(face[0]);
+                indices.push_back(face[i - 1]);
+                indices.push_back(face[i]);
+            }
+        }
+
+        p = pLineEnd;
+        while (*p == '\r' || *p == '\n')
+        {
+            p++;
+        }
+    }
+}
@@ -0,0 +1,212 @@
+#include <pipelinecache.hpp>
+
+#include <string.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+PipelineCache::PipelineCache()
+{
+
+}
+
+PipelineCache::~PipelineCache()
+{
+
+}
+
+void PipelineCache::create(VkPhysicalDevice physicalDevice, VkDevice device, const std::string& path)
+{
+    this->device = device;
+    this->path = path;
+
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    warm = false;
+    pipelineCount = 0;
+    creationSeconds = 0.0;
+
+    std::vector<char> data;
+
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if (file.is_open())
+    {
+        data.resize((size_t) file.tellg());
+
+        file.seekg(0);
+        file.read(data.data(), data.size());
+        file.close();
+    }
+
+    //blobs from another driver or device are ignored rather than handed to the driver
+    if (!data.empty() && validateHeader(data))
+    {
+        warm = true;
+    }
+    else
+    {
+        data.clear();
+    }
+
+    VkPipelineCacheCreateInfo cacheCreateInfo = {};
+    cacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheCreateInfo.initialDataSize = data.size();
+    cacheCreateInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+    if (vkCreatePipelineCache(device, &cacheCreateInfo, nullptr, &cache) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Error! Failed to create pipeline cache!");
+    }
+}
+
+void PipelineCache::destroy()
+{
+    save();
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (const auto& threadCache : threadCaches)
+    {
+        vkDestroyPipelineCache(device, threadCache.second, nullptr);
+    }
+    threadCaches.clear();
+
+    vkDestroyPipelineCache(device, cache, nullptr);
+}
+
+VkPipelineCache PipelineCache::getThreadCache()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::thread::id threadId = std::this_thread::get_id();
+
+    auto it = threadCaches.find(threadId);
+    if (it != threadCaches.end())
+    {
+        return it->second;
+    }
+
+    //seed from the primary cache so threads benefit from the blob loaded at startup
+    size_t dataSize = 0;
+    vkGetPipelineCacheData(device, cache, &dataSize, nullptr);
+
+    std::vector<char> data(dataSize);
+    vkGetPipelineCacheData(device, cache, &dataSize, data.data());
+
+    VkPipelineCacheCreateInfo cacheCreateInfo = {};
+    cacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheCreateInfo.initialDataSize = dataSize;
+    cacheCreateInfo.pInitialData = data.data();
+
+    VkPipelineCache threadCache;
+    if (vkCreatePipelineCache(device, &cacheCreateInfo, nullptr, &threadCache) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Error! Failed to create thread pipeline cache!");
+    }
+
+    threadCaches.insert(std::make_pair(threadId, threadCache));
+
+    return threadCache;
+}
+
+void PipelineCache::merge()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (threadCaches.empty())
+    {
+        return;
+    }
+
+    std::vector<VkPipelineCache> srcCaches;
+    for (const auto& threadCache : threadCaches)
+    {
+        srcCaches.push_back(threadCache.second);
+    }
+
+    if (vkMergePipelineCaches(device, cache, static_cast<uint32_t>(srcCaches.size()), srcCaches.data()) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Error! Failed to merge pipeline caches!");
+    }
+}
+
+void PipelineCache::save()
+{
+    merge();
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    size_t dataSize = 0;
+    if (vkGetPipelineCacheData(device, cache, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0)
+    {
+        return;
+    }
+
+    std::vector<char> data(dataSize);
+    if (vkGetPipelineCacheData(device, cache, &dataSize, data.data()) != VK_SUCCESS)
+    {
+        return;
+    }
+
+    std::string tempPath = path + ".tmp";
+
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        std::cout << "Warning! Failed to write pipeline cache: " << tempPath << std::endl;
+        return;
+    }
+
+    file.write(data.data(), dataSize);
+    file.close();
+
+    if (file.fail() || rename(tempPath.c_str(), path.c_str()) != 0)
+    {
+        std::cout << "Warning! Failed to replace pipeline cache: " << path << std::endl;
+        remove(tempPath.c_str());
+    }
+}
+
+void PipelineCache::recordCreation(uint32_t pipelineCount, double seconds)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    this->pipelineCount += pipelineCount;
+    creationSeconds += seconds;
+}
+
+bool PipelineCache::isWarm()
+{
+    return warm;
+}
+
+PipelineCacheStats PipelineCache::getStats()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    PipelineCacheStats stats = {};
+    stats.warm = warm;
+    stats.pipelineCount = pipelineCount;
+    stats.creationSeconds = creationSeconds;
+    return stats;
+}
+
+bool PipelineCache::validateHeader(const std::vector<char>& data)
+{
+    VkPipelineCacheHeaderVersionOne header;
+    if (data.size() < sizeof(header))
+    {
+        return false;
+    }
+
+    memcpy(&header, data.data(), sizeof(header));
+
+    return header.headerSize >= sizeof(header)
+        && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+        && header.vendorID == properties.vendorID
+        && header.deviceID == properties.deviceID
+        && memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
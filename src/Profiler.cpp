@@ -0,0 +1,267 @@
+#include <profiler.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+const size_t HISTORY_SIZE = 256;
+
+GpuProfiler::GpuProfiler()
+{
+
+}
+
+GpuProfiler::~GpuProfiler()
+{
+
+}
+
+void GpuProfiler::create(VkDevice device, float timestampPeriod, uint32_t timestampValidBits, uint32_t slotCount, uint32_t maxScopes)
+{
+    this->device = device;
+    this->timestampPeriod = timestampPeriod;
+    this->slotCount = slotCount;
+    this->maxScopes = maxScopes;
+
+    timestampMask = timestampValidBits >= 64 ? UINT64_MAX : (uint64_t(1) << timestampValidBits) - 1;
+    enabled = timestampValidBits != 0;
+
+    slotScopes.resize(slotCount);
+    slotSubmitted.resize(slotCount, false);
+
+    queryPool = VK_NULL_HANDLE;
+    if (!enabled)
+    {
+        return;
+    }
+
+    VkQueryPoolCreateInfo queryPoolCreateInfo = {};
+    queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolCreateInfo.queryCount = slotCount * maxScopes * 2;
+
+    if (vkCreateQueryPool(device, &queryPoolCreateInfo, nullptr, &queryPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Error! Failed to create timestamp query pool!");
+    }
+}
+
+void GpuProfiler::destroy()
+{
+    if (queryPool != VK_NULL_HANDLE)
+    {
+        vkDestroyQueryPool(device, queryPool, nullptr);
+        queryPool = VK_NULL_HANDLE;
+    }
+}
+
+void GpuProfiler::reset(VkCommandBuffer commandBuffer, uint32_t slot)
+{
+    if (!enabled)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    slotScopes[slot].clear();
+    slotSubmitted[slot] = false;
+
+    vkCmdResetQueryPool(commandBuffer, queryPool, slot * maxScopes * 2, maxScopes * 2);
+}
+
+uint32_t GpuProfiler::beginScope(VkCommandBuffer commandBuffer, uint32_t slot, const std::string& name, VkPipelineStageFlagBits stage)
+{
+    if (!enabled)
+    {
+        return UINT32_MAX;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::vector<ProfilerScope>& scopes = slotScopes[slot];
+    if (scopes.size() >= maxScopes)
+    {
+        throw std::runtime_error("Error! Too many profiler scopes in frame slot!");
+    }
+
+    ProfilerScope scope = {};
+    scope.name = name;
+    scope.beginQuery = (slot * maxScopes + static_cast<uint32_t>(scopes.size())) * 2;
+    scopes.push_back(scope);
+
+    vkCmdWriteTimestamp(commandBuffer, stage, queryPool, scope.beginQuery);
+
+    return static_cast<uint32_t>(scopes.size() - 1);
+}
+
+void GpuProfiler::endScope(VkCommandBuffer commandBuffer, uint32_t slot, uint32_t scope, VkPipelineStageFlagBits stage)
+{
+    if (!enabled)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    vkCmdWriteTimestamp(commandBuffer, stage, queryPool, slotScopes[slot][scope].beginQuery + 1);
+}
+
+void GpuProfiler::markSubmitted(uint32_t slot)
+{
+    if (!enabled)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    slotSubmitted[slot] = true;
+}
+
+void GpuProfiler::resolve(uint32_t slot)
+{
+    if (!enabled)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    //queries of a slot that was never submitted hold no results yet
+    if (!slotSubmitted[slot] || slotScopes[slot].empty())
+    {
+        return;
+    }
+
+    const std::vector<ProfilerScope>& scopes = slotScopes[slot];
+
+    //each query returns its value followed by its availability
+    uint32_t queryCount = static_cast<uint32_t>(scopes.size()) * 2;
+    std::vector<uint64_t> results(queryCount * 2);
+
+    VkResult result = vkGetQueryPoolResults(device, queryPool, slot * maxScopes * 2, queryCount, results.size() * sizeof(uint64_t), results.data(),
+        2 * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+    if (result != VK_SUCCESS && result != VK_NOT_READY)
+    {
+        throw std::runtime_error("Error! Failed to read timestamp queries!");
+    }
+
+    for (size_t i = 0; i < scopes.size(); i++)
+    {
+        const uint64_t* pBegin = &results[i * 4];
+        const uint64_t* pEnd = &results[i * 4 + 2];
+
+        if (pBegin[1] == 0 || pEnd[1] == 0)
+        {
+            continue;
+        }
+
+        uint64_t ticks = ((pEnd[0] & timestampMask) - (pBegin[0] & timestampMask)) & timestampMask;
+        double milliseconds = static_cast<double>(ticks) * timestampPeriod / 1000000.0;
+
+        std::deque<double>& samples = history[scopes[i].name];
+        samples.push_back(milliseconds);
+        if (samples.size() > HISTORY_SIZE)
+        {
+            samples.pop_front();
+        }
+    }
+
+    slotSubmitted[slot] = false;
+}
+
+std::vector<std::string> GpuProfiler::getScopeNames()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::vector<std::string> names;
+    for (const auto& scope : history)
+    {
+        names.push_back(scope.first);
+    }
+    return names;
+}
+
+ScopeStats GpuProfiler::getStats(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    ScopeStats stats = {};
+
+    auto it = history.find(name);
+    if (it == history.end() || it->second.empty())
+    {
+        return stats;
+    }
+
+    std::vector<double> samples(it->second.begin(), it->second.end());
+    std::sort(samples.begin(), samples.end());
+
+    double sum = 0.0;
+    for (double sample : samples)
+    {
+        sum += sample;
+    }
+
+    //nearest rank percentile
+    size_t p99Index = (samples.size() * 99 + 99) / 100 - 1;
+
+    stats.sampleCount = static_cast<uint32_t>(samples.size());
+    stats.min = samples.front();
+    stats.avg = sum / samples.size();
+    stats.p99 = samples[std::min(p99Index, samples.size() - 1)];
+    stats.max = samples.back();
+
+    return stats;
+}
+
+bool GpuProfiler::dump(const std::string& path)
+{
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    bool json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+
+    std::vector<std::string> names = getScopeNames();
+
+    if (json)
+    {
+        file << "{\n  \"scopes\": [";
+    }
+    else
+    {
+        file << "scope,samples,min_ms,avg_ms,p99_ms,max_ms\n";
+    }
+
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        ScopeStats stats = getStats(names[i]);
+
+        if (json)
+        {
+            file << (i == 0 ? "\n" : ",\n") << "    {\"name\": \"" << names[i] << "\", \"samples\": " << stats.sampleCount
+                << ", \"min\": " << stats.min << ", \"avg\": " << stats.avg << ", \"p99\": " << stats.p99 << ", \"max\": " << stats.max << "}";
+        }
+        else
+        {
+            file << names[i] << "," << stats.sampleCount << "," << stats.min << "," << stats.avg << "," << stats.p99 << "," << stats.max << "\n";
+        }
+    }
+
+    if (json)
+    {
+        file << "\n  ]\n}\n";
+    }
+
+    return file.good();
+}
+
+bool GpuProfiler::isEnabled()
+{
+    return enabled;
+}
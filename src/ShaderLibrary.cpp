@@ -0,0 +1,215 @@
+#include <shaderlibrary.hpp>
+
+#include <iostream>
+#include <stdexcept>
+
+ShaderLibrary::ShaderLibrary()
+{
+
+}
+
+ShaderLibrary::~ShaderLibrary()
+{
+
+}
+
+void ShaderLibrary::create(VkDevice device, bool keepCode)
+{
+    this->device = device;
+    this->keepCode = keepCode;
+
+    createdCount = 0;
+    reusedCount = 0;
+}
+
+void ShaderLibrary::destroy()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (auto& entry : entries)
+    {
+        if (entry.second.module == VK_NULL_HANDLE)
+        {
+            continue;
+        }
+
+        if (entry.second.refCount > 0)
+        {
+            std::cout << "Warning! Shader module destroyed with " << entry.second.refCount << " references left" << std::endl;
+        }
+
+        vkDestroyShaderModule(device, entry.second.module, nullptr);
+    }
+
+    entries.clear();
+    names.clear();
+    modules.clear();
+}
+
+VkShaderModule ShaderLibrary::acquire(const std::vector<char>& code, const std::string& name)
+{
+    ShaderKey key = hashCode(code);
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (!name.empty())
+    {
+        names[name] = key;
+    }
+
+    return acquireEntry(key, entries[key], code);
+}
+
+VkShaderModule ShaderLibrary::acquire(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto nameIt = names.find(name);
+    if (nameIt == names.end())
+    {
+        return VK_NULL_HANDLE;
+    }
+
+    auto entryIt = entries.find(nameIt->second);
+    if (entryIt == entries.end() || (entryIt->second.module == VK_NULL_HANDLE && entryIt->second.code.empty()))
+    {
+        return VK_NULL_HANDLE;
+    }
+
+    return acquireEntry(entryIt->first, entryIt->second, entryIt->second.code);
+}
+
+bool ShaderLibrary::isAvailable(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto nameIt = names.find(name);
+    if (nameIt == names.end())
+    {
+        return false;
+    }
+
+    auto entryIt = entries.find(nameIt->second);
+    return entryIt != entries.end() && (entryIt->second.module != VK_NULL_HANDLE || !entryIt->second.code.empty());
+}
+
+void ShaderLibrary::release(VkShaderModule module)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto moduleIt = modules.find(module);
+    if (moduleIt == modules.end())
+    {
+        throw std::runtime_error("Error! Released shader module is not part of the library!");
+    }
+
+    ShaderKey key = moduleIt->second;
+    ShaderEntry& entry = entries[key];
+
+    if (--entry.refCount > 0)
+    {
+        return;
+    }
+
+    vkDestroyShaderModule(device, entry.module, nullptr);
+    entry.module = VK_NULL_HANDLE;
+    modules.erase(moduleIt);
+
+    if (entry.code.empty())
+    {
+        entries.erase(key);
+    }
+}
+
+std::vector<char> ShaderLibrary::getCode(VkShaderModule module)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto moduleIt = modules.find(module);
+    if (moduleIt == modules.end())
+    {
+        return {};
+    }
+
+    return entries[moduleIt->second].code;
+}
+
+ShaderReflection ShaderLibrary::getReflection(VkShaderModule module)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto moduleIt = modules.find(module);
+    if (moduleIt == modules.end())
+    {
+        throw std::runtime_error("Error! Reflected shader module is not part of the library!");
+    }
+
+    return entries[moduleIt->second].reflection;
+}
+
+ShaderLibraryStats ShaderLibrary::getStats()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    ShaderLibraryStats stats = {};
+    stats.moduleCount = static_cast<uint32_t>(modules.size());
+    stats.createdCount = createdCount;
+    stats.reusedCount = reusedCount;
+
+    for (const auto& entry : entries)
+    {
+        stats.residentBytes += entry.second.code.size();
+    }
+
+    return stats;
+}
+
+ShaderLibrary::ShaderKey ShaderLibrary::hashCode(const std::vector<char>& code)
+{
+    //FNV-1a, the size is part of the key so a collision also needs equal lengths
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : code)
+    {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+    }
+    return std::make_pair(hash, code.size());
+}
+
+VkShaderModule ShaderLibrary::acquireEntry(const ShaderKey& key, ShaderEntry& entry, const std::vector<char>& code)
+{
+    if (entry.module != VK_NULL_HANDLE)
+    {
+        entry.refCount++;
+        reusedCount++;
+        return entry.module;
+    }
+
+    //reflection also rejects code that is not SPIR-V before the driver sees it
+    if (entry.reflection.entryPoint.empty())
+    {
+        entry.reflection = reflectShader(code);
+    }
+
+    VkShaderModuleCreateInfo moduleCreateInfo = {};
+    moduleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    moduleCreateInfo.codeSize = code.size();
+    moduleCreateInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+    VkShaderModule module;
+    if (vkCreateShaderModule(device, &moduleCreateInfo, nullptr, &module) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Error! Failed to create shader module!");
+    }
+
+    if (keepCode && entry.code.empty())
+    {
+        entry.code = code;
+    }
+
+    entry.module = module;
+    entry.refCount = 1;
+    modules[module] = key;
+    createdCount++;
+
+    return module;
+}
@@ -0,0 +1,521 @@
+#include <spirvreflect.hpp>
+
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <stdexcept>
+
+//subset of the SPIR-V grammar reflection needs, values from the unified SPIR-V specification
+const uint32_t SPIRV_MAGIC = 0x07230203;
+
+const uint32_t OP_NAME = 5;
+const uint32_t OP_ENTRY_POINT = 15;
+const uint32_t OP_EXECUTION_MODE = 16;
+const uint32_t OP_TYPE_BOOL = 20;
+const uint32_t OP_TYPE_INT = 21;
+const uint32_t OP_TYPE_FLOAT = 22;
+const uint32_t OP_TYPE_VECTOR = 23;
+const uint32_t OP_TYPE_MATRIX = 24;
+const uint32_t OP_TYPE_IMAGE = 25;
+const uint32_t OP_TYPE_SAMPLER = 26;
+const uint32_t OP_TYPE_SAMPLED_IMAGE = 27;
+const uint32_t OP_TYPE_ARRAY = 28;
+const uint32_t OP_TYPE_RUNTIME_ARRAY = 29;
+const uint32_t OP_TYPE_STRUCT = 30;
+const uint32_t OP_TYPE_POINTER = 32;
+const uint32_t OP_CONSTANT = 43;
+const uint32_t OP_SPEC_CONSTANT_TRUE = 48;
+const uint32_t OP_SPEC_CONSTANT_FALSE = 49;
+const uint32_t OP_SPEC_CONSTANT = 50;
+const uint32_t OP_VARIABLE = 59;
+const uint32_t OP_DECORATE = 71;
+const uint32_t OP_MEMBER_DECORATE = 72;
+
+const uint32_t DECORATION_SPEC_ID = 1;
+const uint32_t DECORATION_BUFFER_BLOCK = 3;
+const uint32_t DECORATION_ARRAY_STRIDE = 6;
+const uint32_t DECORATION_MATRIX_STRIDE = 7;
+const uint32_t DECORATION_BUILT_IN = 11;
+const uint32_t DECORATION_LOCATION = 30;
+const uint32_t DECORATION_BINDING = 33;
+const uint32_t DECORATION_DESCRIPTOR_SET = 34;
+const uint32_t DECORATION_OFFSET = 35;
+
+const uint32_t STORAGE_CLASS_UNIFORM_CONSTANT = 0;
+const uint32_t STORAGE_CLASS_INPUT = 1;
+const uint32_t STORAGE_CLASS_UNIFORM = 2;
+const uint32_t STORAGE_CLASS_OUTPUT = 3;
+const uint32_t STORAGE_CLASS_PUSH_CONSTANT = 9;
+const uint32_t STORAGE_CLASS_STORAGE_BUFFER = 12;
+
+const uint32_t EXECUTION_MODE_LOCAL_SIZE = 17;
+
+const uint32_t DIM_BUFFER = 5;
+const uint32_t DIM_SUBPASS_DATA = 6;
+
+struct SpirvModule
+{
+    //instructions defining types and constants, indexed by result id
+    std::map<uint32_t, std::vector<uint32_t>> definitions;
+    std::map<uint32_t, std::string> names;
+    std::map<uint32_t, std::map<uint32_t, uint32_t>> decorations;
+    std::map<std::pair<uint32_t, uint32_t>, std::map<uint32_t, uint32_t>> memberDecorations;
+
+    const std::vector<uint32_t>& getDefinition(uint32_t id) const;
+    bool getDecoration(uint32_t id, uint32_t decoration, uint32_t& value) const;
+    bool getMemberDecoration(uint32_t id, uint32_t member, uint32_t decoration, uint32_t& value) const;
+    std::string getName(uint32_t id) const;
+    uint32_t getConstant(uint32_t id) const;
+};
+
+const std::vector<uint32_t>& SpirvModule::getDefinition(uint32_t id) const
+{
+    auto it = definitions.find(id);
+    if (it == definitions.end())
+    {
+        throw std::runtime_error("Error! SPIR-V references an undefined type!");
+    }
+    return it->second;
+}
+
+bool SpirvModule::getDecoration(uint32_t id, uint32_t decoration, uint32_t& value) const
+{
+    auto it = decorations.find(id);
+    if (it == decorations.end())
+    {
+        return false;
+    }
+
+    auto decorationIt = it->second.find(decoration);
+    if (decorationIt == it->second.end())
+    {
+        return false;
+    }
+
+    value = decorationIt->second;
+    return true;
+}
+
+bool SpirvModule::getMemberDecoration(uint32_t id, uint32_t member, uint32_t decoration, uint32_t& value) const
+{
+    auto it = memberDecorations.find(std::make_pair(id, member));
+    if (it == memberDecorations.end())
+    {
+        return false;
+    }
+
+    auto decorationIt = it->second.find(decoration);
+    if (decorationIt == it->second.end())
+    {
+        return false;
+    }
+
+    value = decorationIt->second;
+    return true;
+}
+
+std::string SpirvModule::getName(uint32_t id) const
+{
+    auto it = names.find(id);
+    return it == names.end() ? std::string() : it->second;
+}
+
+uint32_t SpirvModule::getConstant(uint32_t id) const
+{
+    //array lengths may be specialisation constants, their default value is used
+    const std::vector<uint32_t>& definition = getDefinition(id);
+    uint32_t opcode = definition[0] & 0xffff;
+    if ((opcode != OP_CONSTANT && opcode != OP_SPEC_CONSTANT) || definition.size() < 4)
+    {
+        throw std::runtime_error("Error! SPIR-V array length is not a scalar constant!");
+    }
+    return definition[3];
+}
+
+std::string readString(const std::vector<uint32_t>& instruction, size_t firstWord, size_t& nextWord)
+{
+    std::string string;
+
+    size_t word = firstWord;
+    for (; word < instruction.size(); word++)
+    {
+        char chars[4];
+        memcpy(chars, &instruction[word], sizeof(chars));
+
+        size_t length = strnlen(chars, sizeof(chars));
+        string.append(chars, length);
+        if (length < sizeof(chars))
+        {
+            word++;
+            break;
+        }
+    }
+
+    nextWord = word;
+    return string;
+}
+
+VkShaderStageFlagBits getStage(uint32_t executionModel)
+{
+    switch (executionModel)
+    {
+        case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+        case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+        case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+        case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+        case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+        case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    throw std::runtime_error("Error! Unsupported SPIR-V execution model!");
+}
+
+uint32_t getTypeSize(const SpirvModule& module, uint32_t typeId, uint32_t matrixStride)
+{
+    const std::vector<uint32_t>& type = module.getDefinition(typeId);
+
+    switch (type[0] & 0xffff)
+    {
+        case OP_TYPE_BOOL:
+            return 4;
+        case OP_TYPE_INT:
+        case OP_TYPE_FLOAT:
+            return type[2] / 8;
+        case OP_TYPE_VECTOR:
+            return type[3] * getTypeSize(module, type[2], 0);
+        case OP_TYPE_MATRIX:
+            return type[3] * (matrixStride != 0 ? matrixStride : getTypeSize(module, type[2], 0));
+        case OP_TYPE_ARRAY:
+        {
+            uint32_t length = module.getConstant(type[3]);
+
+            uint32_t arrayStride;
+            if (module.getDecoration(typeId, DECORATION_ARRAY_STRIDE, arrayStride))
+            {
+                return length * arrayStride;
+            }
+            return length * getTypeSize(module, type[2], matrixStride);
+        }
+        case OP_TYPE_RUNTIME_ARRAY:
+            return 0;
+        case OP_TYPE_STRUCT:
+        {
+            uint32_t size = 0;
+            for (uint32_t member = 0; member + 2 < type.size(); member++)
+            {
+                uint32_t memberMatrixStride = 0;
+                module.getMemberDecoration(typeId, member, DECORATION_MATRIX_STRIDE, memberMatrixStride);
+
+                uint32_t memberSize = getTypeSize(module, type[member + 2], memberMatrixStride);
+
+                //explicit layouts place members by offset, the end of the furthest member is the size
+                uint32_t offset;
+                if (module.getMemberDecoration(typeId, member, DECORATION_OFFSET, offset))
+                {
+                    size = std::max(size, offset + memberSize);
+                }
+                else
+                {
+                    size += memberSize;
+                }
+            }
+            return size;
+        }
+    }
+
+    throw std::runtime_error("Error! Unsupported SPIR-V type in sized block!");
+}
+
+ShaderVariable getVariable(const SpirvModule& module, uint32_t typeId, uint32_t location, const std::string& name)
+{
+    ShaderVariable variable = {};
+    variable.location = location;
+    variable.name = name;
+
+    //arrays and matrices take one location per element or column, the first one describes them all
+    const std::vector<uint32_t>* pType = &module.getDefinition(typeId);
+    while ((((*pType)[0] & 0xffff) == OP_TYPE_ARRAY) || (((*pType)[0] & 0xffff) == OP_TYPE_MATRIX))
+    {
+        pType = &module.getDefinition((*pType)[2]);
+    }
+
+    variable.componentCount = 1;
+    if (((*pType)[0] & 0xffff) == OP_TYPE_VECTOR)
+    {
+        variable.componentCount = (*pType)[3];
+        pType = &module.getDefinition((*pType)[2]);
+    }
+
+    switch ((*pType)[0] & 0xffff)
+    {
+        case OP_TYPE_FLOAT:
+            variable.type = SHADER_INPUT_FLOAT;
+            break;
+        case OP_TYPE_INT:
+            variable.type = (*pType)[3] != 0 ? SHADER_INPUT_INT : SHADER_INPUT_UINT;
+            break;
+        default:
+            throw std::runtime_error("Error! Unsupported SPIR-V interface variable type!");
+    }
+
+    return variable;
+}
+
+VkDescriptorType getDescriptorType(const SpirvModule& module, uint32_t storageClass, uint32_t typeId)
+{
+    const std::vector<uint32_t>& type = module.getDefinition(typeId);
+
+    switch (type[0] & 0xffff)
+    {
+        case OP_TYPE_STRUCT:
+        {
+            uint32_t unused;
+            if (storageClass == STORAGE_CLASS_STORAGE_BUFFER || module.getDecoration(typeId, DECORATION_BUFFER_BLOCK, unused))
+            {
+                return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            }
+            return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        }
+        case OP_TYPE_SAMPLER:
+            return VK_DESCRIPTOR_TYPE_SAMPLER;
+        case OP_TYPE_SAMPLED_IMAGE:
+        {
+            const std::vector<uint32_t>& image = module.getDefinition(type[2]);
+            return image[3] == DIM_BUFFER ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        }
+        case OP_TYPE_IMAGE:
+        {
+            //'sampled' is 2 for images accessed without a sampler
+            if (type[3] == DIM_SUBPASS_DATA)
+            {
+                return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+            }
+            if (type[7] == 2)
+            {
+                return type[3] == DIM_BUFFER ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            }
+            return type[3] == DIM_BUFFER ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        }
+    }
+
+    throw std::runtime_error("Error! Unsupported SPIR-V descriptor type!");
+}
+
+ShaderReflection reflectShader(const std::vector<char>& code)
+{
+    if (code.size() < 5 * sizeof(uint32_t) || code.size() % sizeof(uint32_t) != 0)
+    {
+        throw std::runtime_error("Error! SPIR-V code is truncated!");
+    }
+
+    std::vector<uint32_t> words(code.size() / sizeof(uint32_t));
+    memcpy(words.data(), code.data(), code.size());
+
+    if (words[0] != SPIRV_MAGIC)
+    {
+        throw std::runtime_error("Error! Code is not SPIR-V!");
+    }
+
+    SpirvModule module;
+
+    struct Variable
+    {
+        uint32_t id;
+        uint32_t typeId;
+        uint32_t storageClass;
+    };
+
+    std::vector<Variable> variables;
+    std::vector<std::vector<uint32_t>> specConstants;
+
+    bool entryPointFound = false;
+    uint32_t entryPointId = 0;
+    std::set<uint32_t> interfaceIds;
+
+    ShaderReflection reflection = {};
+    reflection.localSize[0] = reflection.localSize[1] = reflection.localSize[2] = 1;
+
+    //the header is five words, instructions follow
+    size_t offset = 5;
+    while (offset < words.size())
+    {
+        uint32_t wordCount = words[offset] >> 16;
+        uint32_t opcode = words[offset] & 0xffff;
+
+        if (wordCount == 0 || offset + wordCount > words.size())
+        {
+            throw std::runtime_error("Error! SPIR-V instruction is truncated!");
+        }
+
+        std::vector<uint32_t> instruction(words.begin() + offset, words.begin() + offset + wordCount);
+        offset += wordCount;
+
+        switch (opcode)
+        {
+            case OP_NAME:
+            {
+                size_t next;
+                module.names[instruction[1]] = readString(instruction, 2, next);
+                break;
+            }
+            case OP_ENTRY_POINT:
+            {
+                if (entryPointFound)
+                {
+                    break;
+                }
+                entryPointFound = true;
+
+                reflection.stage = getStage(instruction[1]);
+                entryPointId = instruction[2];
+
+                size_t next;
+                reflection.entryPoint = readString(instruction, 3, next);
+                interfaceIds.insert(instruction.begin() + next, instruction.end());
+                break;
+            }
+            case OP_EXECUTION_MODE:
+            {
+                if (instruction[1] == entryPointId && instruction[2] == EXECUTION_MODE_LOCAL_SIZE && wordCount >= 6)
+                {
+                    reflection.localSize[0] = instruction[3];
+                    reflection.localSize[1] = instruction[4];
+                    reflection.localSize[2] = instruction[5];
+                }
+                break;
+            }
+            case OP_DECORATE:
+            {
+                module.decorations[instruction[1]][instruction[2]] = wordCount > 3 ? instruction[3] : 0;
+                break;
+            }
+            case OP_MEMBER_DECORATE:
+            {
+                module.memberDecorations[std::make_pair(instruction[1], instruction[2])][instruction[3]] = wordCount > 4 ? instruction[4] : 0;
+                break;
+            }
+            case OP_CONSTANT:
+            case OP_SPEC_CONSTANT:
+            case OP_SPEC_CONSTANT_TRUE:
+            case OP_SPEC_CONSTANT_FALSE:
+            {
+                module.definitions[instruction[2]] = instruction;
+                if (opcode != OP_CONSTANT)
+                {
+                    specConstants.push_back(instruction);
+                }
+                break;
+            }
+            case OP_VARIABLE:
+            {
+                Variable variable = {instruction[2], instruction[1], instruction[3]};
+                variables.push_back(variable);
+                break;
+            }
+            default:
+            {
+                if (opcode >= OP_TYPE_BOOL && opcode <= OP_TYPE_POINTER)
+                {
+                    module.definitions[instruction[1]] = instruction;
+                }
+                break;
+            }
+        }
+    }
+
+    if (!entryPointFound)
+    {
+        throw std::runtime_error("Error! SPIR-V module has no entry point!");
+    }
+
+    for (const auto& variable : variables)
+    {
+        //pointer types hold the storage class and the pointee type
+        uint32_t typeId = module.getDefinition(variable.typeId)[3];
+        std::string name = module.getName(variable.id);
+
+        uint32_t location;
+        uint32_t builtIn;
+        switch (variable.storageClass)
+        {
+            case STORAGE_CLASS_INPUT:
+            case STORAGE_CLASS_OUTPUT:
+            {
+                if (interfaceIds.count(variable.id) == 0 || module.getDecoration(variable.id, DECORATION_BUILT_IN, builtIn)
+                    || !module.getDecoration(variable.id, DECORATION_LOCATION, location))
+                {
+                    break;
+                }
+
+                ShaderVariable shaderVariable = getVariable(module, typeId, location, name);
+                (variable.storageClass == STORAGE_CLASS_INPUT ? reflection.inputs : reflection.outputs).push_back(shaderVariable);
+                break;
+            }
+            case STORAGE_CLASS_UNIFORM_CONSTANT:
+            case STORAGE_CLASS_UNIFORM:
+            case STORAGE_CLASS_STORAGE_BUFFER:
+            {
+                ShaderBinding binding = {};
+                if (!module.getDecoration(variable.id, DECORATION_DESCRIPTOR_SET, binding.set)
+                    || !module.getDecoration(variable.id, DECORATION_BINDING, binding.binding))
+                {
+                    break;
+                }
+
+                binding.descriptorCount = 1;
+                while (true)
+                {
+                    const std::vector<uint32_t>& type = module.getDefinition(typeId);
+                    if ((type[0] & 0xffff) == OP_TYPE_ARRAY)
+                    {
+                        binding.descriptorCount *= module.getConstant(type[3]);
+                    }
+                    else if ((type[0] & 0xffff) != OP_TYPE_RUNTIME_ARRAY)
+                    {
+                        break;
+                    }
+                    typeId = type[2];
+                }
+
+                binding.descriptorType = getDescriptorType(module, variable.storageClass, typeId);
+
+                //blocks are usually named through their type, the instance name is optional
+                binding.name = name.empty() ? module.getName(typeId) : name;
+                reflection.bindings.push_back(binding);
+                break;
+            }
+            case STORAGE_CLASS_PUSH_CONSTANT:
+            {
+                reflection.pushConstantSize = std::max(reflection.pushConstantSize, getTypeSize(module, typeId, 0));
+                break;
+            }
+        }
+    }
+
+    for (const auto& instruction : specConstants)
+    {
+        ShaderSpecConstant specConstant = {};
+        if (!module.getDecoration(instruction[2], DECORATION_SPEC_ID, specConstant.constantId))
+        {
+            continue;
+        }
+
+        specConstant.size = getTypeSize(module, instruction[1], 0);
+        specConstant.name = module.getName(instruction[2]);
+        reflection.specConstants.push_back(specConstant);
+    }
+
+    std::sort(reflection.inputs.begin(), reflection.inputs.end(), [](const ShaderVariable& a, const ShaderVariable& b) {
+        return a.location < b.location;
+    });
+    std::sort(reflection.outputs.begin(), reflection.outputs.end(), [](const ShaderVariable& a, const ShaderVariable& b) {
+        return a.location < b.location;
+    });
+    std::sort(reflection.bindings.begin(), reflection.bindings.end(), [](const ShaderBinding& a, const ShaderBinding& b) {
+        return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+    });
+
+    return reflection;
+}
@@ -0,0 +1,243 @@
+#include <staging.hpp>
+
+#include <stdexcept>
+
+StagingRing::StagingRing()
+{
+
+}
+
+StagingRing::~StagingRing()
+{
+
+}
+
+void StagingRing::create(VkDevice device, VkBuffer buffer, void* pMapped, VkDeviceSize capacity)
+{
+    this->device = device;
+    this->buffer = buffer;
+    this->pMapped = pMapped;
+    this->capacity = capacity;
+
+    head = 0;
+    pendingBegin = 0;
+    pendingCount = 0;
+
+    submittedSerial = 0;
+    completedSerial = 0;
+}
+
+void StagingRing::destroy()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (auto& submission : submissions)
+    {
+        vkWaitForFences(device, 1, &submission.fence, VK_TRUE, UINT64_MAX);
+        release(submission);
+    }
+    submissions.clear();
+
+    for (VkFence fence : freeFences)
+    {
+        vkDestroyFence(device, fence, nullptr);
+    }
+    freeFences.clear();
+
+    //semaphores may still be owned by unacquired uploads, so destroy every one created
+    for (VkSemaphore semaphore : semaphores)
+    {
+        vkDestroySemaphore(device, semaphore, nullptr);
+    }
+    semaphores.clear();
+    freeSemaphores.clear();
+}
+
+StagingRegion StagingRing::allocate(VkDeviceSize size, VkDeviceSize alignment)
+{
+    if (size > capacity)
+    {
+        throw std::runtime_error("Error! Upload exceeds staging ring capacity!");
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    while (true)
+    {
+        reclaimSignalled();
+
+        bool empty = submissions.empty() && pendingCount == 0;
+        if (empty)
+        {
+            head = 0;
+            pendingBegin = 0;
+        }
+
+        VkDeviceSize tail = submissions.empty() ? pendingBegin : submissions.front().begin;
+        VkDeviceSize offset = (head + alignment - 1) & ~(alignment - 1);
+
+        bool fits = false;
+        if (empty || head > tail)
+        {
+            if (offset + size <= capacity)
+            {
+                fits = true;
+            }
+            else if (size <= tail)
+            {
+                //wrap around, the skipped tail end is released with this region
+                offset = 0;
+                fits = true;
+            }
+        }
+        else if (head < tail)
+        {
+            fits = offset + size <= tail;
+        }
+
+        if (fits)
+        {
+            head = offset + size;
+            pendingCount++;
+
+            StagingRegion region = {};
+            region.buffer = buffer;
+            region.offset = offset;
+            region.size = size;
+            region.pMapped = static_cast<char*>(pMapped) + offset;
+
+            return region;
+        }
+
+        if (submissions.empty())
+        {
+            throw std::runtime_error("Error! Staging ring exhausted by unsubmitted uploads!");
+        }
+
+        vkWaitForFences(device, 1, &submissions.front().fence, VK_TRUE, UINT64_MAX);
+    }
+}
+
+VkFence StagingRing::acquireFence()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (!freeFences.empty())
+    {
+        VkFence fence = freeFences.back();
+        freeFences.pop_back();
+        return fence;
+    }
+
+    VkFenceCreateInfo fenceCreateInfo = {};
+    fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    VkFence fence;
+    if (vkCreateFence(device, &fenceCreateInfo, nullptr, &fence) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Error! Failed to create staging fence!");
+    }
+
+    return fence;
+}
+
+VkSemaphore StagingRing::acquireSemaphore()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (!freeSemaphores.empty())
+    {
+        VkSemaphore semaphore = freeSemaphores.back();
+        freeSemaphores.pop_back();
+        return semaphore;
+    }
+
+    VkSemaphoreCreateInfo semaphoreCreateInfo = {};
+    semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    VkSemaphore semaphore;
+    if (vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &semaphore) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Error! Failed to create staging semaphore!");
+    }
+
+    semaphores.push_back(semaphore);
+    return semaphore;
+}
+
+uint64_t StagingRing::submit(VkFence fence, VkCommandPool pool, VkCommandBuffer commandBuffer, const std::vector<VkSemaphore>& semaphores)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    StagingSubmission submission = {};
+    submission.serial = ++submittedSerial;
+    submission.begin = pendingBegin;
+    submission.end = head;
+    submission.fence = fence;
+    submission.pool = pool;
+    submission.commandBuffer = commandBuffer;
+    submission.semaphores = semaphores;
+
+    submissions.push_back(submission);
+
+    pendingBegin = head;
+    pendingCount = 0;
+
+    return submission.serial;
+}
+
+uint64_t StagingRing::getCompletedSerial()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    reclaimSignalled();
+
+    return completedSerial;
+}
+
+void StagingRing::waitForSerial(uint64_t serial)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    while (!submissions.empty() && submissions.front().serial <= serial)
+    {
+        vkWaitForFences(device, 1, &submissions.front().fence, VK_TRUE, UINT64_MAX);
+        reclaimSignalled();
+    }
+}
+
+void StagingRing::reclaim()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    reclaimSignalled();
+}
+
+VkDeviceSize StagingRing::getCapacity()
+{
+    return capacity;
+}
+
+void StagingRing::reclaimSignalled()
+{
+    while (!submissions.empty() && vkGetFenceStatus(device, submissions.front().fence) == VK_SUCCESS)
+    {
+        completedSerial = submissions.front().serial;
+
+        release(submissions.front());
+        submissions.pop_front();
+    }
+}
+
+void StagingRing::release(StagingSubmission& submission)
+{
+    if (submission.commandBuffer != VK_NULL_HANDLE)
+    {
+        vkFreeCommandBuffers(device, submission.pool, 1, &submission.commandBuffer);
+    }
+
+    freeSemaphores.insert(freeSemaphores.end(), submission.semaphores.begin(), submission.semaphores.end());
+
+    vkResetFences(device, 1, &submission.fence);
+    freeFences.push_back(submission.fence);
+}
@@ -0,0 +1,121 @@
+#include <threadpool.hpp>
+
+#include <algorithm>
+
+ThreadPool::ThreadPool()
+{
+
+}
+
+ThreadPool::~ThreadPool()
+{
+
+}
+
+void ThreadPool::create(uint32_t threadCount)
+{
+    pTask = nullptr;
+    taskCount = 0;
+    nextTask = 0;
+    completedTasks = 0;
+    stopping = false;
+
+    threadCount = std::max(threadCount, 1u);
+    for (uint32_t i = 0; i < threadCount; i++)
+    {
+        threads.emplace_back(&ThreadPool::work, this, i);
+    }
+}
+
+void ThreadPool::destroy()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    threads.clear();
+}
+
+void ThreadPool::run(uint32_t taskCount, const std::function<void(uint32_t, uint32_t)>& task)
+{
+    if (taskCount == 0)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> runLock(runMutex);
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    pTask = &task;
+    this->taskCount = taskCount;
+    nextTask = 0;
+    completedTasks = 0;
+    error = nullptr;
+
+    workAvailable.notify_all();
+    workDone.wait(lock, [this] { return completedTasks == this->taskCount; });
+
+    pTask = nullptr;
+    this->taskCount = 0;
+
+    if (error)
+    {
+        std::exception_ptr taskError = error;
+        error = nullptr;
+        std::rethrow_exception(taskError);
+    }
+}
+
+uint32_t ThreadPool::getThreadCount()
+{
+    return static_cast<uint32_t>(threads.size());
+}
+
+void ThreadPool::work(uint32_t threadIndex)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true)
+    {
+        workAvailable.wait(lock, [this] { return stopping || nextTask < taskCount; });
+
+        if (stopping)
+        {
+            return;
+        }
+
+        uint32_t taskIndex = nextTask++;
+        const std::function<void(uint32_t, uint32_t)>* pCurrentTask = pTask;
+
+        lock.unlock();
+
+        std::exception_ptr taskError = nullptr;
+        try
+        {
+            (*pCurrentTask)(taskIndex, threadIndex);
+        }
+        catch (...)
+        {
+            taskError = std::current_exception();
+        }
+
+        lock.lock();
+
+        if (taskError && !error)
+        {
+            error = taskError;
+        }
+
+        if (++completedTasks == taskCount)
+        {
+            workDone.notify_all();
+        }
+    }
+}
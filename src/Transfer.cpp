@@ -0,0 +1,162 @@
+#include <transfer.hpp>
+
+#include <algorithm>
+
+bool ImageCopyTarget::operator<(const ImageCopyTarget& other) const
+{
+    return std::tie(srcBuffer, dstImage, dstLayout) < std::tie(other.srcBuffer, other.dstImage, other.dstLayout);
+}
+
+TransferBatch::TransferBatch()
+{
+    async = false;
+    stagedBytes = 0;
+}
+
+TransferBatch::~TransferBatch()
+{
+
+}
+
+void TransferBatch::setAsync(bool async)
+{
+    this->async = async;
+}
+
+bool TransferBatch::isAsync()
+{
+    return async;
+}
+
+void TransferBatch::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize srcOffset, VkDeviceSize dstOffset, VkDeviceSize size)
+{
+    VkBufferCopy copyRegion = {};
+    copyRegion.srcOffset = srcOffset;
+    copyRegion.dstOffset = dstOffset;
+    copyRegion.size = size;
+
+    bufferCopies[std::make_pair(srcBuffer, dstBuffer)].push_back(copyRegion);
+}
+
+void TransferBatch::copyBufferToImage(VkBuffer srcBuffer, VkImage dstImage, VkImageLayout dstLayout, const VkBufferImageCopy& region)
+{
+    ImageCopyTarget target = {srcBuffer, dstImage, dstLayout};
+    imageCopies[target].push_back(region);
+}
+
+uint32_t TransferBatch::record(VkCommandBuffer commandBuffer)
+{
+    uint32_t regionCount = 0;
+
+    for (auto& bufferCopy : bufferCopies)
+    {
+        std::vector<VkBufferCopy>& regions = bufferCopy.second;
+
+        std::sort(regions.begin(), regions.end(), [](const VkBufferCopy& a, const VkBufferCopy& b) {
+            return a.srcOffset < b.srcOffset;
+        });
+
+        //merge regions contiguous in both source and destination
+        std::vector<VkBufferCopy> merged;
+        merged.reserve(regions.size());
+        for (const auto& region : regions)
+        {
+            if (!merged.empty())
+            {
+                VkBufferCopy& last = merged.back();
+                if (last.srcOffset + last.size == region.srcOffset && last.dstOffset + last.size == region.dstOffset)
+                {
+                    last.size += region.size;
+                    continue;
+                }
+            }
+
+            merged.push_back(region);
+        }
+
+        vkCmdCopyBuffer(commandBuffer, bufferCopy.first.first, bufferCopy.first.second, static_cast<uint32_t>(merged.size()), merged.data());
+        regionCount += static_cast<uint32_t>(merged.size());
+    }
+
+    for (auto& imageCopy : imageCopies)
+    {
+        const ImageCopyTarget& target = imageCopy.first;
+        std::vector<VkBufferImageCopy>& regions = imageCopy.second;
+
+        vkCmdCopyBufferToImage(commandBuffer, target.srcBuffer, target.dstImage, target.dstLayout, static_cast<uint32_t>(regions.size()), regions.data());
+        regionCount += static_cast<uint32_t>(regions.size());
+    }
+
+    return regionCount;
+}
+
+std::set<VkBuffer> TransferBatch::getDstBuffers()
+{
+    std::set<VkBuffer> dstBuffers;
+    for (const auto& bufferCopy : bufferCopies)
+    {
+        dstBuffers.insert(bufferCopy.first.second);
+    }
+    return dstBuffers;
+}
+
+std::vector<ImageTransferTarget> TransferBatch::getDstImages()
+{
+    std::map<VkImage, ImageTransferTarget> dstImages;
+    for (const auto& imageCopy : imageCopies)
+    {
+        ImageTransferTarget& target = dstImages[imageCopy.first.dstImage];
+        target.image = imageCopy.first.dstImage;
+        target.layout = imageCopy.first.dstLayout;
+
+        for (const auto& region : imageCopy.second)
+        {
+            target.aspectMask |= region.imageSubresource.aspectMask;
+        }
+    }
+
+    std::vector<ImageTransferTarget> targets;
+    for (const auto& dstImage : dstImages)
+    {
+        targets.push_back(dstImage.second);
+    }
+    return targets;
+}
+
+VkDeviceSize TransferBatch::getStagedBytes()
+{
+    return stagedBytes;
+}
+
+void TransferBatch::addStagedBytes(VkDeviceSize size)
+{
+    stagedBytes += size;
+}
+
+bool TransferBatch::empty()
+{
+    return bufferCopies.empty() && imageCopies.empty();
+}
+
+void TransferBatch::clear()
+{
+    bufferCopies.clear();
+    imageCopies.clear();
+    stagedBytes = 0;
+}
+
+void TransferBatch::lock(std::recursive_mutex& mutex)
+{
+    if (!uploadLock.owns_lock())
+    {
+        uploadLock = std::unique_lock<std::recursive_mutex>(mutex);
+    }
+}
+
+void TransferBatch::unlock()
+{
+    if (uploadLock.owns_lock())
+    {
+        uploadLock.unlock();
+    }
+}
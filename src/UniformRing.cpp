@@ -0,0 +1,87 @@
+#include <uniformring.hpp>
+
+#include <device.hpp>
+
+UniformRing::UniformRing()
+{
+
+}
+
+UniformRing::~UniformRing()
+{
+
+}
+
+void UniformRing::create(Device& device, uint32_t frameCount, VkDeviceSize frameCapacity)
+{
+    alignment = device.getMinUniformBufferOffsetAlignment();
+
+    //regions start aligned so offsets only need aligning relative to the region
+    this->frameCapacity = (frameCapacity + alignment - 1) / alignment * alignment;
+
+    //dynamic offsets are 32 bit
+    if (this->frameCapacity * frameCount > UINT32_MAX)
+    {
+        throw std::runtime_error("Error! Uniform ring is larger than dynamic offsets can address!");
+    }
+
+    device.createBuffer(this->frameCapacity * frameCount, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, buffer, allocation);
+
+    frameBegin = 0;
+    head = 0;
+}
+
+void UniformRing::destroy(Device& device)
+{
+    device.destroyBuffer(buffer, allocation);
+}
+
+void UniformRing::beginFrame(uint32_t frame)
+{
+    frameBegin = frame * frameCapacity;
+    head = 0;
+}
+
+UniformAllocation UniformRing::allocate(VkDeviceSize size)
+{
+    return allocateArray(size, 1);
+}
+
+UniformAllocation UniformRing::allocateArray(VkDeviceSize size, uint32_t count)
+{
+    VkDeviceSize stride = getStride(size);
+
+    if (head + stride * count > frameCapacity)
+    {
+        throw std::runtime_error("Error! Uniform ring frame capacity exceeded!");
+    }
+
+    UniformAllocation uniforms = {};
+    uniforms.offset = static_cast<uint32_t>(frameBegin + head);
+    uniforms.stride = static_cast<uint32_t>(stride);
+    uniforms.pMapped = static_cast<char*>(allocation.pMapped) + frameBegin + head;
+
+    head += stride * count;
+
+    return uniforms;
+}
+
+VkDeviceSize UniformRing::getStride(VkDeviceSize size)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+VkBuffer UniformRing::getBuffer()
+{
+    return buffer;
+}
+
+VkDeviceSize UniformRing::getFrameUsage()
+{
+    return head;
+}
+
+VkDeviceSize UniformRing::getFrameCapacity()
+{
+    return frameCapacity;
+}
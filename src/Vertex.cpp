@@ -0,0 +1,29 @@
+#include <vertex.hpp>
+
+#include <string.h>
+
+bool Vertex::operator==(const Vertex& other) const
+{
+    return pos == other.pos && color == other.color;
+}
+
+size_t VertexHash::operator()(const Vertex& vertex) const
+{
+    float values[] = {vertex.pos.x, vertex.pos.y, vertex.color.x, vertex.color.y, vertex.color.z};
+
+    //FNV-1a, -0.0f and 0.0f compare equal so they must hash equal too
+    size_t hash = 14695981039346656037ull;
+    for (float value : values)
+    {
+        if (value == 0.0f)
+        {
+            value = 0.0f;
+        }
+
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+
+        hash = (hash ^ bits) * 1099511628211ull;
+    }
+    return hash;
+}
@@ -0,0 +1,249 @@
+#include <vertexformat.hpp>
+
+#include <string.h>
+
+#include <cmath>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+uint32_t getVertexStride(VertexFormat format)
+{
+    switch (format)
+    {
+        case VERTEX_FORMAT_FLOAT: return VERTEX_STREAM.stride;
+        case VERTEX_FORMAT_HALF: return VERTEX_HALF_STREAM.stride;
+        case VERTEX_FORMAT_SNORM16: return VERTEX_SNORM16_STREAM.stride;
+    }
+
+    throw std::runtime_error("Error! Unknown vertex format!");
+}
+
+uint16_t encodeHalf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t magnitude = bits & 0x7fffffff;
+
+    //infinity and nan, nan keeps a quiet bit
+    if (magnitude >= 0x7f800000)
+    {
+        return static_cast<uint16_t>(sign | 0x7c00 | (magnitude > 0x7f800000 ? 0x200 : 0));
+    }
+
+    //rounds to a value above the largest half
+    if (magnitude >= 0x477ff000)
+    {
+        return static_cast<uint16_t>(sign | 0x7c00);
+    }
+
+    uint32_t half;
+    uint32_t remainder;
+    uint32_t halfway;
+
+    if (magnitude < 0x38800000)
+    {
+        //half subnormal, count in units of 2^-24
+        uint32_t shift = 126 - (magnitude >> 23);
+        if (shift > 31)
+        {
+            return static_cast<uint16_t>(sign);
+        }
+
+        uint32_t mantissa = (magnitude & 0x7fffff) | 0x800000;
+        half = mantissa >> shift;
+        remainder = mantissa & ((1u << shift) - 1);
+        halfway = 1u << (shift - 1);
+    }
+    else
+    {
+        //rebias the exponent, the mantissa carry rolls into it on rounding
+        half = (magnitude - 0x38000000) >> 13;
+        remainder = magnitude & 0x1fff;
+        halfway = 0x1000;
+    }
+
+    if (remainder > halfway || (remainder == halfway && (half & 1)))
+    {
+        half++;
+    }
+
+    return static_cast<uint16_t>(sign | half);
+}
+
+int16_t encodeSnorm16(float value)
+{
+    value = std::fmin(std::fmax(value, -1.0f), 1.0f);
+    return static_cast<int16_t>(std::nearbyint(value * 32767.0f));
+}
+
+uint8_t encodeUnorm8(float value)
+{
+    value = std::fmin(std::fmax(value, 0.0f), 1.0f);
+    return static_cast<uint8_t>(std::nearbyint(value * 255.0f));
+}
+
+void encodeHalf(const float* pSrc, uint16_t* pDst, size_t count)
+{
+    size_t i = 0;
+
+#if defined(__F16C__)
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 values = _mm256_loadu_ps(pSrc + i);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), _mm256_cvtps_ph(values, _MM_FROUND_TO_NEAREST_INT));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 4 <= count; i += 4)
+    {
+        float16x4_t values = vcvt_f16_f32(vld1q_f32(pSrc + i));
+        vst1_u16(pDst + i, vreinterpret_u16_f16(values));
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        pDst[i] = encodeHalf(pSrc[i]);
+    }
+}
+
+void encodeSnorm16(const float* pSrc, int16_t* pDst, size_t count)
+{
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128 minValue = _mm_set1_ps(-1.0f);
+    const __m128 maxValue = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(32767.0f);
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128 low = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(pSrc + i), minValue), maxValue), scale);
+        __m128 high = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(pSrc + i + 4), minValue), maxValue), scale);
+
+        //conversion uses the current rounding mode, nearest even like std::nearbyint
+        __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(low), _mm_cvtps_epi32(high));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), packed);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const float32x4_t minValue = vdupq_n_f32(-1.0f);
+    const float32x4_t maxValue = vdupq_n_f32(1.0f);
+
+    for (; i + 8 <= count; i += 8)
+    {
+        float32x4_t low = vmulq_n_f32(vminq_f32(vmaxq_f32(vld1q_f32(pSrc + i), minValue), maxValue), 32767.0f);
+        float32x4_t high = vmulq_n_f32(vminq_f32(vmaxq_f32(vld1q_f32(pSrc + i + 4), minValue), maxValue), 32767.0f);
+
+        int16x8_t packed = vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(low)), vqmovn_s32(vcvtnq_s32_f32(high)));
+        vst1q_s16(pDst + i, packed);
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        pDst[i] = encodeSnorm16(pSrc[i]);
+    }
+}
+
+void encodeUnorm8(const float* pSrc, uint8_t* pDst, size_t count)
+{
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128 minValue = _mm_setzero_ps();
+    const __m128 maxValue = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(255.0f);
+
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i words[4];
+        for (int j = 0; j < 4; j++)
+        {
+            __m128 values = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(pSrc + i + j * 4), minValue), maxValue), scale);
+            words[j] = _mm_cvtps_epi32(values);
+        }
+
+        __m128i packed = _mm_packus_epi16(_mm_packs_epi32(words[0], words[1]), _mm_packs_epi32(words[2], words[3]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), packed);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const float32x4_t minValue = vdupq_n_f32(0.0f);
+    const float32x4_t maxValue = vdupq_n_f32(1.0f);
+
+    for (; i + 8 <= count; i += 8)
+    {
+        float32x4_t low = vmulq_n_f32(vminq_f32(vmaxq_f32(vld1q_f32(pSrc + i), minValue), maxValue), 255.0f);
+        float32x4_t high = vmulq_n_f32(vminq_f32(vmaxq_f32(vld1q_f32(pSrc + i + 4), minValue), maxValue), 255.0f);
+
+        uint16x8_t words = vcombine_u16(vqmovn_u32(vcvtnq_u32_f32(low)), vqmovn_u32(vcvtnq_u32_f32(high)));
+        vst1_u8(pDst + i, vqmovn_u16(words));
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        pDst[i] = encodeUnorm8(pSrc[i]);
+    }
+}
+
+std::vector<uint8_t> packVertices(const std::vector<Vertex>& vertices, VertexFormat format)
+{
+    size_t vertexCount = vertices.size();
+    uint32_t stride = getVertexStride(format);
+
+    std::vector<uint8_t> packed(vertexCount * stride);
+
+    if (format == VERTEX_FORMAT_FLOAT)
+    {
+        memcpy(packed.data(), vertices.data(), packed.size());
+        return packed;
+    }
+
+    //split into attribute streams so each is converted in one bulk call
+    std::vector<float> positions(vertexCount * 2);
+    std::vector<float> colors(vertexCount * 4);
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        positions[i * 2] = vertices[i].pos.x;
+        positions[i * 2 + 1] = vertices[i].pos.y;
+        colors[i * 4] = vertices[i].color.x;
+        colors[i * 4 + 1] = vertices[i].color.y;
+        colors[i * 4 + 2] = vertices[i].color.z;
+        colors[i * 4 + 3] = 1.0f;
+    }
+
+    std::vector<uint16_t> encodedPositions(positions.size());
+    std::vector<uint8_t> encodedColors(colors.size());
+
+    if (format == VERTEX_FORMAT_HALF)
+    {
+        encodeHalf(positions.data(), encodedPositions.data(), positions.size());
+    }
+    else
+    {
+        encodeSnorm16(positions.data(), reinterpret_cast<int16_t*>(encodedPositions.data()), positions.size());
+    }
+
+    encodeUnorm8(colors.data(), encodedColors.data(), colors.size());
+
+    //both packed layouts are a 4 byte position followed by a 4 byte color
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        memcpy(&packed[i * stride], &encodedPositions[i * 2], 4);
+        memcpy(&packed[i * stride + 4], &encodedColors[i * 4], 4);
+    }
+
+    return packed;
+}
@@ -2,12 +2,15 @@
 #include <utils.hpp>
 #include <device.hpp>
 
+#include <algorithm>
 #include <array>
 #include <iostream>
+#include <map>
 #include <set>
 #include <stdexcept>
 #include <sstream>
 
+#include <string.h>
 #include <unistd.h>
 
 const std::vector<Vertex> vertices = {
@@ -21,39 +24,139 @@ const std::vector<uint16_t> indices = {
     0, 1, 2, 2, 3, 0
 };
 
-const int MAX_FRAMES_IN_FLIGHT = 2;
+//upper bound of frames in flight over all present policies
+const uint32_t MAX_FRAMES_IN_FLIGHT = 3;
 
-VkVertexInputBindingDescription Vertex::getBindingDescription()
+const VkFormat OFFSCREEN_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+
+const uint32_t MAX_PROFILER_SCOPES = 16;
+
+//uniform data written by one frame, per-draw blocks included
+const VkDeviceSize UNIFORM_RING_FRAME_SIZE = 256 * 1024;
+
+const char* VERTEX_SHADER_PATH = "build/resources/shaders/vertex.spv";
+const char* FRAGMENT_SHADER_PATH = "build/resources/shaders/fragment.spv";
+const char* CULL_SHADER_PATH = "build/resources/shaders/cull.spv";
+
+//inputs declared by vertex.vert, every layout the window pipeline can be created with is checked against them
+constexpr std::array<ShaderInput, 4> VERTEX_SHADER_INPUTS = {{
+    {0, SHADER_INPUT_FLOAT}, {1, SHADER_INPUT_FLOAT}, {2, SHADER_INPUT_FLOAT}, {3, SHADER_INPUT_FLOAT}}};
+
+//indexed by VertexFormat, binding 0 advances per vertex, binding 1 per instance
+constexpr std::array<VertexLayout<2, 4>, 3> VERTEX_LAYOUTS = {{
+    makeVertexLayout(VERTEX_STREAM, INSTANCE_STREAM),
+    makeVertexLayout(VERTEX_HALF_STREAM, INSTANCE_STREAM),
+    makeVertexLayout(VERTEX_SNORM16_STREAM, INSTANCE_STREAM)}};
+
+static_assert(matchesShaderInputs(VERTEX_LAYOUTS[VERTEX_FORMAT_FLOAT], VERTEX_SHADER_INPUTS), "Float vertex layout does not match vertex.vert");
+static_assert(matchesShaderInputs(VERTEX_LAYOUTS[VERTEX_FORMAT_HALF], VERTEX_SHADER_INPUTS), "Half vertex layout does not match vertex.vert");
+static_assert(matchesShaderInputs(VERTEX_LAYOUTS[VERTEX_FORMAT_SNORM16], VERTEX_SHADER_INPUTS), "Snorm16 vertex layout does not match vertex.vert");
+
+PresentConfig getPresentConfig(PresentPolicy policy)
 {
-    VkVertexInputBindingDescription bindingDescription = {};
-    bindingDescription.binding = 0;
-    bindingDescription.stride = sizeof(Vertex);
-    bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    PresentConfig config = {};
+
+    switch (policy)
+    {
+        case PRESENT_POLICY_LOW_LATENCY:
+            //a single frame in flight, newest image always shown
+            config.framesInFlight = 1;
+            config.extraImages = 1;
+            config.presentModes = {VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR};
+            break;
+        case PRESENT_POLICY_THROUGHPUT:
+            //keep the GPU saturated, tearing is acceptable
+            config.framesInFlight = 3;
+            config.extraImages = 2;
+            config.presentModes = {VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR};
+            break;
+        case PRESENT_POLICY_POWER_SAVE:
+            //vsync with as few images as possible so the GPU idles between frames
+            config.framesInFlight = 2;
+            config.extraImages = 0;
+            break;
+        default:
+            config.framesInFlight = 2;
+            config.extraImages = 1;
+            config.presentModes = {VK_PRESENT_MODE_MAILBOX_KHR};
+            break;
+    }
 
-    return bindingDescription;
+    return config;
 }
 
-std::array<VkVertexInputAttributeDescription, 2> Vertex::getAttributeDescriptions()
+//dynamic topology may only switch within the class of the topology the pipeline was built with
+int getTopologyClass(VkPrimitiveTopology topology)
 {
-    std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions = {};
-    attributeDescriptions[0].binding = 0;
-    attributeDescriptions[0].location = 0;
-    attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
-    attributeDescriptions[0].offset = offsetof(Vertex, pos);
-    attributeDescriptions[1].binding = 0;
-    attributeDescriptions[1].location = 1;
-    attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-    attributeDescriptions[1].offset = offsetof(Vertex, color);
-    return attributeDescriptions;
+    switch (topology)
+    {
+        case VK_PRIMITIVE_TOPOLOGY_POINT_LIST:
+            return 0;
+        case VK_PRIMITIVE_TOPOLOGY_LINE_LIST:
+        case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:
+        case VK_PRIMITIVE_TOPOLOGY_LINE_LIST_WITH_ADJACENCY:
+        case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP_WITH_ADJACENCY:
+            return 1;
+        case VK_PRIMITIVE_TOPOLOGY_PATCH_LIST:
+            return 3;
+        default:
+            return 2;
+    }
 }
 
-bool Vertex::operator==(const Vertex& other) const
+std::vector<VkResult> presentFrames(const std::vector<FramePresent>& frames)
 {
-    return pos == other.pos && color == other.color;
+    std::vector<VkResult> results(frames.size(), VK_SUCCESS);
+
+    //swapchains presented on the same queue go out in a single call
+    std::map<VkQueue, std::vector<size_t>> queueFrames;
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+        if (frames[i].rendered && frames[i].present)
+        {
+            queueFrames[frames[i].queue].push_back(i);
+        }
+    }
+
+    for (const auto& queueFrame : queueFrames)
+    {
+        std::vector<VkSemaphore> waitSemaphores;
+        std::vector<VkSwapchainKHR> swapchains;
+        std::vector<uint32_t> imageIndices;
+
+        for (size_t frame : queueFrame.second)
+        {
+            waitSemaphores.push_back(frames[frame].waitSemaphore);
+            swapchains.push_back(frames[frame].swapchain);
+            imageIndices.push_back(frames[frame].imageIndex);
+        }
+
+        std::vector<VkResult> swapchainResults(swapchains.size(), VK_SUCCESS);
+
+        VkPresentInfoKHR presentInfo = {};
+        presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+        presentInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+        presentInfo.pWaitSemaphores = waitSemaphores.data();
+        presentInfo.swapchainCount = static_cast<uint32_t>(swapchains.size());
+        presentInfo.pSwapchains = swapchains.data();
+        presentInfo.pImageIndices = imageIndices.data();
+        presentInfo.pResults = swapchainResults.data();
+
+        //the per swapchain results tell which window is out of date, the overall result only the worst case
+        frames[queueFrame.second[0]].device->queuePresent(queueFrame.first, &presentInfo);
+
+        for (size_t i = 0; i < queueFrame.second.size(); i++)
+        {
+            results[queueFrame.second[i]] = swapchainResults[i];
+        }
+    }
+
+    return results;
 }
 
 Window::Window()
 {
+    device = nullptr;
     window = nullptr;
 
     width = 100;
@@ -64,6 +167,60 @@ Window::Window()
 
     launched = false;
     shown = false;
+
+    headless = false;
+    frameLimit = 0;
+    frameCount = 0;
+    lastImageIndex = 0;
+    framebufferWidth = 0;
+    framebufferHeight = 0;
+    recreatePending = false;
+
+    profiler = nullptr;
+    threadPool = nullptr;
+    recordThreadCount = 0;
+    assetLoader = nullptr;
+    vertShaderModule = VK_NULL_HANDLE;
+    fragShaderModule = VK_NULL_HANDLE;
+    cullShaderModule = VK_NULL_HANDLE;
+
+    presentPolicy = PRESENT_POLICY_BALANCED;
+    framesInFlight = getPresentConfig(presentPolicy).framesInFlight;
+
+    swapchain.swapchain = VK_NULL_HANDLE;
+
+    viewportRect = {0.0f, 0.0f, 1.0f, 1.0f};
+    frameUniforms.viewTransform = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+    cullMode = VK_CULL_MODE_BACK_BIT;
+    frontFace = VK_FRONT_FACE_CLOCKWISE;
+    topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    //a single untransformed instance draws the mesh as is
+    InstanceData identity = {};
+    identity.transform = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+    identity.color = glm::vec3(1.0f, 1.0f, 1.0f);
+    instances.push_back(identity);
+    drawMode = DRAW_MODE_INSTANCED;
+
+    vertexFormat = VERTEX_FORMAT_FLOAT;
+    indexCount = static_cast<uint32_t>(indices.size());
+    indexType = VK_INDEX_TYPE_UINT16;
+
+    gpuCulling = false;
+    cullPassCreated = false;
+
+    meshRadius = 0.0f;
+    for (const auto& vertex : vertices)
+    {
+        meshRadius = std::max(meshRadius, glm::length(vertex.pos));
+    }
+
+    //without a camera the frustum is the clip space volume
+    cullPlanes = {
+        glm::vec4(1.0f, 0.0f, 0.0f, 1.0f), glm::vec4(-1.0f, 0.0f, 0.0f, 1.0f),
+        glm::vec4(0.0f, 1.0f, 0.0f, 1.0f), glm::vec4(0.0f, -1.0f, 0.0f, 1.0f),
+        glm::vec4(0.0f, 0.0f, 1.0f, 0.0f), glm::vec4(0.0f, 0.0f, -1.0f, 1.0f)
+    };
 }
 
 Window::~Window()
@@ -79,6 +236,12 @@ void Window::setWidth(int width)
     {
         glfwSetWindowSize(window, this->width, this->height);
     }
+
+    //offscreen targets have no surface to report the change, resize them directly
+    if (headless && launched)
+    {
+        recreateSwapchain();
+    }
 }
 
 void Window::setHeight(int height)
@@ -89,6 +252,12 @@ void Window::setHeight(int height)
     {
         glfwSetWindowSize(window, this->width, this->height);
     }
+
+    //offscreen targets have no surface to report the change, resize them directly
+    if (headless && launched)
+    {
+        recreateSwapchain();
+    }
 }
 
 void Window::setSize(int width, int height)
@@ -100,6 +269,12 @@ void Window::setSize(int width, int height)
     {
         glfwSetWindowSize(window, this->width, this->height);
     }
+
+    //offscreen targets have no surface to report the change, resize them directly
+    if (headless && launched)
+    {
+        recreateSwapchain();
+    }
 }
 
 void Window::setTitle(char* title)
@@ -112,6 +287,163 @@ void Window::setTitle(char* title)
     }
 }
 
+void Window::setHeadless(bool headless)
+{
+    if (launched)
+    {
+        throw std::runtime_error("Error! Cannot change headless mode of a launched window!");
+    }
+
+    this->headless = headless;
+}
+
+bool Window::isHeadless()
+{
+    return headless;
+}
+
+void Window::setFrameLimit(uint32_t frameLimit)
+{
+    this->frameLimit = frameLimit;
+}
+
+void Window::setPresentPolicy(PresentPolicy policy)
+{
+    presentPolicy = policy;
+
+    if (!launched)
+    {
+        framesInFlight = getPresentConfig(presentPolicy).framesInFlight;
+        return;
+    }
+
+    //semaphores may still be waited on by presentation, which fences do not cover
+    device->waitIdle();
+
+    destroySyncObjects();
+    destroyFrameContexts();
+
+    framesInFlight = getPresentConfig(presentPolicy).framesInFlight;
+    currentFrame = 0;
+
+    recreateSwapchain();
+    destroyRetiredSwapchains(true);
+
+    createFrameContexts();
+    createSyncObjects();
+}
+
+PresentPolicy Window::getPresentPolicy()
+{
+    return presentPolicy;
+}
+
+void Window::setInstances(const std::vector<InstanceData>& instances)
+{
+    this->instances = instances;
+}
+
+void Window::setDrawMode(DrawMode drawMode)
+{
+    this->drawMode = drawMode;
+}
+
+DrawMode Window::getDrawMode()
+{
+    return drawMode;
+}
+
+void Window::setRecordThreadCount(uint32_t threadCount)
+{
+    if (launched)
+    {
+        throw std::runtime_error("Error! Record thread count can only be changed before launch!");
+    }
+
+    recordThreadCount = threadCount;
+}
+
+uint32_t Window::getRecordThreadCount()
+{
+    return recordThreadCount;
+}
+
+void Window::setVertexFormat(VertexFormat vertexFormat)
+{
+    if (launched)
+    {
+        throw std::runtime_error("Error! Vertex format can only be changed before launch!");
+    }
+
+    this->vertexFormat = vertexFormat;
+}
+
+void Window::setMesh(const std::string& path)
+{
+    if (launched)
+    {
+        throw std::runtime_error("Error! Mesh can only be changed before launch!");
+    }
+
+    //only the header is read here, the pipeline needs the vertex format before the streams are uploaded
+    MeshFile meshFile;
+    meshFile.create(path);
+
+    vertexFormat = meshFile.getVertexFormat();
+    indexCount = meshFile.getHeader().indexCount;
+    indexType = meshFile.getIndexType();
+    meshRadius = meshFile.getHeader().radius;
+
+    meshFile.destroy();
+
+    meshPath = path;
+}
+
+void Window::setGpuCulling(bool gpuCulling)
+{
+    this->gpuCulling = gpuCulling;
+}
+
+void Window::setCullPlanes(const std::array<glm::vec4, 6>& planes)
+{
+    cullPlanes = planes;
+}
+
+void Window::setViewport(float x, float y, float width, float height)
+{
+    //viewport and scissor are dynamic, the next recorded frame picks this up
+    viewportRect = {x, y, width, height};
+}
+
+void Window::setViewTransform(const glm::vec2& offset, const glm::vec2& scale)
+{
+    //written to the uniform ring when the next frame is recorded
+    frameUniforms.viewTransform = glm::vec4(offset, scale);
+}
+
+void Window::setRasterState(VkCullModeFlags cullMode, VkFrontFace frontFace, VkPrimitiveTopology topology)
+{
+    bool changed = cullMode != this->cullMode || frontFace != this->frontFace || topology != this->topology;
+    bool topologyClassChanged = getTopologyClass(topology) != getTopologyClass(this->topology);
+
+    this->cullMode = cullMode;
+    this->frontFace = frontFace;
+    this->topology = topology;
+
+    //without extended dynamic state these are baked into the pipeline, with it the topology class still is
+    if (launched && (device->isExtendedDynamicStateSupported() ? topologyClassChanged : changed))
+    {
+        if (!inFlightFences.empty())
+        {
+            device->waitForFences(static_cast<uint32_t>(inFlightFences.size()), inFlightFences.data(), VK_TRUE, UINT64_MAX);
+        }
+
+        device->destroyPipeline(pipeline.pipeline, nullptr);
+
+        createGraphicsPipeline();
+    }
+}
+
 void Window::show() 
 {
     shown = true;
@@ -129,169 +461,476 @@ void Window::hide()
     destroySwapchain();
 }
 
-void Window::launch(std::vector<Device>& devices)
+void Window::launch(DeviceRegistry& registry, AssetLoader& assetLoader)
 {
     if (!launched)
     {
         launched = true;
 
-        window = glfwCreateWindow(width, height, title, nullptr, nullptr);
-        if (glfwCreateWindowSurface(getInstance(), window, nullptr, &surface) != VK_SUCCESS)
-        {
-            throw std::runtime_error("Error! Failed to create window surface!");
-        }
+        //shaders and the mesh are read while the device and swapchain are created
+        this->assetLoader = &assetLoader;
+        vertShaderAsset = assetLoader.load(VERTEX_SHADER_PATH, ASSET_PRIORITY_HIGH);
+        fragShaderAsset = assetLoader.load(FRAGMENT_SHADER_PATH, ASSET_PRIORITY_HIGH);
+        cullShaderAsset = assetLoader.load(CULL_SHADER_PATH);
 
-        std::cout << surface << std::endl;
-
-        if (devices.empty())
+        if (!meshPath.empty())
         {
-            device.create(surface);
-            devices.push_back(device);
+            std::string path = meshPath;
+            meshAsset = assetLoader.load<std::shared_ptr<MeshFile>>(meshPath, [path](std::vector<char>& data)
+            {
+                //validated on the worker, the streams are staged from the loaded contents
+                std::shared_ptr<MeshFile> meshFile = std::make_shared<MeshFile>();
+                meshFile->create(data, path);
+                return meshFile;
+            }, ASSET_PRIORITY_HIGH);
         }
-        else
-        {
-            int bestRating = 0;
-            Device bestDevice;
 
-            for (Device device : devices)
-            {
-                if (device.getRating(surface) > bestRating)
-                {
-                    bestDevice = device;
-                }
-            }
+        surface = VK_NULL_HANDLE;
 
-            if (bestRating <= 0)
-            {
-                device.create(surface);
-            }
-            else
+        if (!headless)
+        {
+            window = glfwCreateWindow(width, height, title, nullptr, nullptr);
+            glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+            if (glfwCreateWindowSurface(getInstance(), window, nullptr, &surface) != VK_SUCCESS)
             {
-                device = bestDevice;
+                throw std::runtime_error("Error! Failed to create window surface!");
             }
         }
-        
-        if (device.getPhysicalDeviceSurfaceSupport(surface) != VK_TRUE)
-        {
-            throw std::runtime_error("Error! Surface not supported by device");
-        }
 
-        createSwapchain();
+        //windows whose surface an existing device can present to share it and everything created on it
+        device = registry.acquire(surface);
+
+        //start geometry uploads first so they overlap swapchain and pipeline creation
+        createGeometryBuffers();
+        createSwapchain(VK_NULL_HANDLE);
+
+        //one slot per frame in flight, results of a slot are read once the frame's fence has signalled
+        profiler = device->createProfiler(MAX_FRAMES_IN_FLIGHT, MAX_PROFILER_SCOPES);
+
+        //workers record secondary command buffers, the calling thread records the primary one
+        threadPool = new ThreadPool();
+        threadPool->create(recordThreadCount > 0 ? recordThreadCount : std::max(std::thread::hardware_concurrency(), 2u) - 1);
+
         createRenderPass();
         createGraphicsPipeline();
         createFramebuffers();
-        createVertexBuffer();
-        createIndexBuffer();
-        createCommandBuffers();
+        createFrameContexts();
         createSyncObjects();
+
+        //geometry uploads ran on the transfer queue, hand them to the graphics queue before the first frame
+        device->acquireUpload(geometryUpload);
     }
 
-    glfwShowWindow(window);
+    if (!headless)
+    {
+        glfwShowWindow(window);
+    }
 }
 
 void Window::drawFrame()
 {
-    uint32_t imageIndex;
-    VkResult result = device.acquireNextImageKHR(swapchain.swapchain, UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+    //windows driven without an application dispatch the loader themselves
+    assetLoader->dispatchCompleted();
+
+    prepareFrame();
+
+    FramePresent framePresent = renderFrame();
+    if (!framePresent.rendered)
+    {
+        return;
+    }
+
+    std::vector<VkResult> results = presentFrames({framePresent});
+    finishFrame(results[0]);
+}
+
+void Window::prepareFrame()
+{
+    //GLFW may only be queried on the main thread, renderFrame works with this copy
+    if (!headless)
+    {
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+    }
+}
+
+FramePresent Window::renderFrame()
+{
+    FramePresent framePresent = {};
+    framePresent.rendered = false;
+    framePresent.present = false;
+
+    //the frame's previous submission must finish before its command pools and timestamps are reused
+    device->waitForFences(1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
 
-    if (result != VK_SUCCESS)
+    destroyRetiredSwapchains(false);
+
+    recreatePending = false;
+
+    uint32_t imageIndex;
+    if (headless)
     {
-        throw std::runtime_error("Error! Failed to acquire swapchain image!");
+        //offscreen images are used round robin, no acquire or present is involved
+        imageIndex = static_cast<uint32_t>(frameCount % swapchain.images.size());
+    }
+    else
+    {
+        //minimised, nothing to render into
+        if (framebufferWidth == 0 || framebufferHeight == 0)
+        {
+            return framePresent;
+        }
+
+        if (static_cast<uint32_t>(framebufferWidth) != swapchain.extent.width || static_cast<uint32_t>(framebufferHeight) != swapchain.extent.height)
+        {
+            recreateSwapchain();
+        }
+
+        VkResult result = device->acquireNextImageKHR(swapchain.swapchain, UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+
+        if (result == VK_ERROR_OUT_OF_DATE_KHR)
+        {
+            //the semaphore was not signalled, so the frame can simply be retried
+            recreateSwapchain();
+            return framePresent;
+        }
+        else if (result == VK_SUBOPTIMAL_KHR)
+        {
+            //the image is still presentable, recreate once it has been handed back
+            recreatePending = true;
+        }
+        else if (result != VK_SUCCESS)
+        {
+            throw std::runtime_error("Error! Failed to acquire swapchain image!");
+        }
     }
 
     if (imagesInFlight[imageIndex] != VK_NULL_HANDLE)
     {
-        device.waitForFences(1, &imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
+        device->waitForFences(1, &imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
     }
 
     imagesInFlight[imageIndex] = inFlightFences[currentFrame];
 
+    profiler->resolve(static_cast<uint32_t>(currentFrame));
+    frameContexts[currentFrame].reset(*device);
+
+    //direct draws take a uniform block each, grow the ring before a frame runs out of space
+    VkDeviceSize uniformSize = uniformRing.getStride(sizeof(FrameUniforms)) + uniformRing.getStride(sizeof(DrawUniforms)) * std::max<size_t>(instances.size(), 1);
+    if (uniformSize > uniformRing.getFrameCapacity())
+    {
+        //every region moves to the new buffer, no frame may still read the old one
+        device->waitForFences(static_cast<uint32_t>(inFlightFences.size()), inFlightFences.data(), VK_TRUE, UINT64_MAX);
+
+        VkDeviceSize frameCapacity = std::max(uniformSize, uniformRing.getFrameCapacity() * 2);
+        uniformRing.destroy(*device);
+        uniformRing.create(*device, framesInFlight, frameCapacity);
+    }
+
+    uniformRing.beginFrame(static_cast<uint32_t>(currentFrame));
+
+    updateInstanceBuffer();
+
+    bool culling = isGpuCullingActive();
+    if (culling)
+    {
+        submitCulling();
+    }
+
+    VkCommandBuffer commandBuffer = recordCommandBuffer(imageIndex, culling);
+
     VkSubmitInfo submitInfo = {};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-    VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]};
-    VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = waitSemaphores;
-    submitInfo.pWaitDstStageMask = waitStages;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffers[imageIndex];
+    std::vector<VkSemaphore> waitSemaphores;
+    std::vector<VkPipelineStageFlags> waitStages;
 
-    VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[currentFrame]};
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = signalSemaphores;
+    if (!headless)
+    {
+        waitSemaphores.push_back(imageAvailableSemaphores[currentFrame]);
+        waitStages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &renderFinishedSemaphores[currentFrame];
+    }
+
+    //draws are read from the buffers written by the culling pass
+    if (culling)
+    {
+        waitSemaphores.push_back(cullFinishedSemaphores[currentFrame]);
+        waitStages.push_back(VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+    }
+
+    submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+    submitInfo.pWaitSemaphores = waitSemaphores.data();
+    submitInfo.pWaitDstStageMask = waitStages.data();
+
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
 
-    device.waitForFences(1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
-    device.resetFences(1, &inFlightFences[currentFrame]);
+    device->resetFences(1, &inFlightFences[currentFrame]);
 
-    Queue queue = device.getGraphicsQueues()[0];
-    if (vkQueueSubmit(queue.queue, 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS)
+    Queue queue = device->getGraphicsQueues()[0];
+    if (device->queueSubmit(queue.queue, 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS)
     {
         throw std::runtime_error("Error! Failed to submit to queue!");
     }
 
-    VkPresentInfoKHR presentInfo = {};
-    presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-    presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores = signalSemaphores;
-    
-    VkSwapchainKHR swapchains[] = {swapchain.swapchain};
-    presentInfo.swapchainCount = 1;
-    presentInfo.pSwapchains = swapchains;
-    presentInfo.pImageIndices = &imageIndex;
+    profiler->markSubmitted(static_cast<uint32_t>(currentFrame));
 
-    presentInfo.pResults = nullptr;
+    lastImageIndex = imageIndex;
 
-    Queue presentQueue = device.getGraphicsQueues()[1];
+    framePresent.rendered = true;
+    framePresent.imageIndex = imageIndex;
 
-    result = vkQueuePresentKHR(presentQueue.queue, &presentInfo);
+    if (!headless)
+    {
+        framePresent.present = true;
+        framePresent.device = device;
+        framePresent.queue = device->getGraphicsQueues()[1].queue;
+        framePresent.swapchain = swapchain.swapchain;
+        framePresent.waitSemaphore = renderFinishedSemaphores[currentFrame];
+    }
 
-    if (result != VK_SUCCESS)
+    return framePresent;
+}
+
+void Window::finishFrame(VkResult presentResult)
+{
+    if (presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR)
+    {
+        recreatePending = true;
+    }
+    else if (presentResult != VK_SUCCESS)
     {
         throw std::runtime_error("Error! Failed to present swapchain image!");
     }
 
-    currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    currentFrame = (currentFrame + 1) % framesInFlight;
+    frameCount++;
+
+    if (recreatePending)
+    {
+        recreateSwapchain();
+    }
+}
+
+std::vector<uint8_t> Window::readPixels()
+{
+    if (!headless)
+    {
+        throw std::runtime_error("Error! Pixels can only be read back from headless windows!");
+    }
+
+    if (frameCount == 0)
+    {
+        throw std::runtime_error("Error! No frame has been rendered yet!");
+    }
+
+    if (imagesInFlight[lastImageIndex] != VK_NULL_HANDLE)
+    {
+        device->waitForFences(1, &imagesInFlight[lastImageIndex], VK_TRUE, UINT64_MAX);
+    }
+
+    VkDeviceSize size = static_cast<VkDeviceSize>(swapchain.extent.width) * swapchain.extent.height * 4;
+
+    VkBuffer readbackBuffer;
+    Allocation readbackAllocation;
+    device->createBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, readbackBuffer, readbackAllocation);
+
+    Queue queue = device->getGraphicsQueues()[0];
+    VkCommandPool commandPool = device->getCommandPool(queue);
+
+    VkCommandBuffer commandBuffer = device->beginSingleTimeCommands(commandPool);
+
+    //the render pass leaves offscreen images in TRANSFER_SRC_OPTIMAL
+    VkBufferImageCopy region = {};
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset = {0, 0, 0};
+    region.imageExtent = {swapchain.extent.width, swapchain.extent.height, 1};
+
+    vkCmdCopyImageToBuffer(commandBuffer, swapchain.images[lastImageIndex], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbackBuffer, 1, &region);
+
+    //make the copy visible to the host read below
+    VkBufferMemoryBarrier readbackBarrier = {};
+    readbackBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    readbackBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    readbackBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    readbackBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    readbackBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    readbackBarrier.buffer = readbackBuffer;
+    readbackBarrier.offset = 0;
+    readbackBarrier.size = VK_WHOLE_SIZE;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &readbackBarrier, 0, nullptr);
+
+    device->endSingleTimeCommands(commandBuffer, commandPool, queue.queue);
+
+    std::vector<uint8_t> pixels((size_t) size);
+    memcpy(pixels.data(), readbackAllocation.pMapped, (size_t) size);
+
+    device->destroyBuffer(readbackBuffer, readbackAllocation);
+
+    return pixels;
 }
 
 void Window::destroy()
 {
-    device.waitIdle();
+    //never launched, nothing was created on a device
+    if (device == nullptr)
+    {
+        return;
+    }
+
+    device->waitIdle();
 
+    destroyRetiredSwapchains(true);
     destroySwapchain();
 
-    device.freeMemory(vertexBufferMemory, nullptr);
-    device.freeMemory(indexBufferMemory, nullptr);
+    if (profiler != nullptr)
+    {
+        if (!profileOutput.empty() && !profiler->dump(profileOutput))
+        {
+            std::cout << "Warning! Failed to write GPU profile: " << profileOutput << std::endl;
+        }
+
+        device->destroyProfiler(profiler);
+        profiler = nullptr;
+    }
 
-    device.destroyBuffer(vertexBuffer, nullptr);
-    device.destroyBuffer(indexBuffer, nullptr);
+    destroyFrameContexts();
 
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    if (cullPassCreated)
     {
-        device.destroySemaphore(imageAvailableSemaphores[i], nullptr);
-        device.destroySemaphore(renderFinishedSemaphores[i], nullptr);
-        device.destroyFence(inFlightFences[i], nullptr);
+        cullPass.destroy(*device);
+        cullPassCreated = false;
     }
 
-    vkDestroySurfaceKHR(getInstance(), surface, nullptr);
+    //modules shared with other windows live on until their last user releases them
+    VkShaderModule* shaderModules[] = {&vertShaderModule, &fragShaderModule, &cullShaderModule};
+    for (VkShaderModule* pModule : shaderModules)
+    {
+        if (*pModule != VK_NULL_HANDLE)
+        {
+            device->getShaderLibrary()->release(*pModule);
+            *pModule = VK_NULL_HANDLE;
+        }
+    }
 
-    glfwDestroyWindow(window);
-    window = nullptr;
+    if (threadPool != nullptr)
+    {
+        threadPool->destroy();
+        delete threadPool;
+        threadPool = nullptr;
+    }
+
+    //the loader is shared with other windows
+    assetLoader = nullptr;
+
+    //geometry shared with other windows lives on until their last user releases it
+    device->getGeometryCache()->release(*device, vertexBuffer);
+
+    destroySyncObjects();
+
+    if (!headless)
+    {
+        vkDestroySurfaceKHR(getInstance(), surface, nullptr);
+
+        glfwDestroyWindow(window);
+        window = nullptr;
+    }
 }
 
 bool Window::shouldClose()
 {
-    return glfwWindowShouldClose(window);
+    if (headless)
+    {
+        return frameLimit != 0 && frameCount >= frameLimit;
+    }
+
+    return glfwWindowShouldClose(window);
+}
+
+VkSurfaceKHR Window::getSurface()
+{
+    return surface;
+}
+
+GpuProfiler* Window::getProfiler()
+{
+    return profiler;
+}
+
+AssetLoader* Window::getAssetLoader()
+{
+    return assetLoader;
+}
+
+void Window::setProfileOutput(const std::string& path)
+{
+    profileOutput = path;
 }
 
-VkSurfaceKHR Window::getSurface()
+void Window::createOffscreenImages()
 {
-    return surface;
+    swapchain.swapchain = VK_NULL_HANDLE;
+    swapchain.format = OFFSCREEN_FORMAT;
+    swapchain.extent = {static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
+
+    //one image per frame in flight, frames never wait on each other's images
+    swapchain.images.resize(framesInFlight);
+    swapchain.imageViews.resize(framesInFlight);
+    offscreenAllocations.resize(framesInFlight);
+
+    for (uint32_t i = 0; i < framesInFlight; i++)
+    {
+        VkImageCreateInfo imageCreateInfo = {};
+        imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageCreateInfo.format = swapchain.format;
+        imageCreateInfo.extent = {swapchain.extent.width, swapchain.extent.height, 1};
+        imageCreateInfo.mipLevels = 1;
+        imageCreateInfo.arrayLayers = 1;
+        imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageCreateInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        device->createImage(&imageCreateInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, swapchain.images[i], offscreenAllocations[i]);
+
+        VkImageViewCreateInfo imageViewCreateInfo = {};
+        imageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        imageViewCreateInfo.image = swapchain.images[i];
+        imageViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        imageViewCreateInfo.format = swapchain.format;
+        imageViewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        imageViewCreateInfo.subresourceRange.baseMipLevel = 0;
+        imageViewCreateInfo.subresourceRange.levelCount = 1;
+        imageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
+        imageViewCreateInfo.subresourceRange.layerCount = 1;
+
+        if (device->createImageView(&imageViewCreateInfo, nullptr, &swapchain.imageViews[i]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Error! Failed to create image view!");
+        }
+    }
 }
 
-void Window::createSwapchain()
+void Window::createSwapchain(VkSwapchainKHR oldSwapchain)
 {
-    SwapchainSupportDetails swapchainSupportDetails = device.getSwapchainSupportDetails(surface);
+    if (headless)
+    {
+        createOffscreenImages();
+        return;
+    }
+
+    SwapchainSupportDetails swapchainSupportDetails = device->getSwapchainSupportDetails(surface);
 
     VkSurfaceFormatKHR surfaceFormat = swapchainSupportDetails.formats[0];
     for (const auto& availableFormat : swapchainSupportDetails.formats)
@@ -303,12 +942,16 @@ void Window::createSwapchain()
         }
     }
 
+    PresentConfig presentConfig = getPresentConfig(presentPolicy);
+
+    //take the first supported mode in order of preference, FIFO is always available
     VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
-    for (const auto& availablePresentMode : swapchainSupportDetails.presentModes)
+    for (const auto& preferredPresentMode : presentConfig.presentModes)
     {
-        if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+        auto& availablePresentModes = swapchainSupportDetails.presentModes;
+        if (std::find(availablePresentModes.begin(), availablePresentModes.end(), preferredPresentMode) != availablePresentModes.end())
         {
-            presentMode = availablePresentMode;
+            presentMode = preferredPresentMode;
             break;
         }
     }
@@ -320,12 +963,10 @@ void Window::createSwapchain()
     }
     else
     {
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
-
+        //size cached on the main thread, the swapchain may be recreated by a render thread
         VkExtent2D actualExtent = {
-            static_cast<uint32_t>(width),
-            static_cast<uint32_t>(height)
+            static_cast<uint32_t>(framebufferWidth),
+            static_cast<uint32_t>(framebufferHeight)
         };
 
         actualExtent.width = std::max(
@@ -344,7 +985,7 @@ void Window::createSwapchain()
         extent = actualExtent;
     }
 
-    uint32_t imageCount = swapchainSupportDetails.capabilities.minImageCount + 1;
+    uint32_t imageCount = swapchainSupportDetails.capabilities.minImageCount + presentConfig.extraImages;
 
     if (swapchainSupportDetails.capabilities.maxImageCount > 0 && imageCount > swapchainSupportDetails.capabilities.maxImageCount)
     {
@@ -361,7 +1002,7 @@ void Window::createSwapchain()
     swapchainCreateInfo.imageArrayLayers = 1;
     swapchainCreateInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
 
-    auto graphicsQueues = device.getGraphicsQueues();
+    auto graphicsQueues = device->getGraphicsQueues();
     std::set<uint32_t> uniqueQueueFamilies;
     for (auto& graphicsQueue : graphicsQueues)
     {
@@ -385,16 +1026,16 @@ void Window::createSwapchain()
     swapchainCreateInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
     swapchainCreateInfo.presentMode = presentMode;
     swapchainCreateInfo.clipped = VK_TRUE;
-    swapchainCreateInfo.oldSwapchain = VK_NULL_HANDLE;
+    swapchainCreateInfo.oldSwapchain = oldSwapchain;
 
-    if (device.createSwapchain(&swapchainCreateInfo, nullptr, &swapchain.swapchain) != VK_SUCCESS)
+    if (device->createSwapchain(&swapchainCreateInfo, nullptr, &swapchain.swapchain) != VK_SUCCESS)
     {
         throw std::runtime_error("Error! Failed to create swapchain!");
     }
 
-    device.getSwapchainImages(swapchain.swapchain, &imageCount, nullptr);
+    device->getSwapchainImages(swapchain.swapchain, &imageCount, nullptr);
     swapchain.images.resize(imageCount);
-    device.getSwapchainImages(swapchain.swapchain, &imageCount, swapchain.images.data());
+    device->getSwapchainImages(swapchain.swapchain, &imageCount, swapchain.images.data());
 
     swapchain.format = surfaceFormat.format;
     swapchain.extent = extent;
@@ -414,7 +1055,7 @@ void Window::createSwapchain()
         imageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
         imageViewCreateInfo.subresourceRange.layerCount = 1;
 
-        if (device.createImageView(&imageViewCreateInfo, nullptr, &swapchain.imageViews[i]) != VK_SUCCESS)
+        if (device->createImageView(&imageViewCreateInfo, nullptr, &swapchain.imageViews[i]) != VK_SUCCESS)
         {
             throw std::runtime_error("Error! Failed to create image view!");
         }
@@ -431,7 +1072,7 @@ void Window::createRenderPass()
     colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    colorAttachment.finalLayout = headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
     VkAttachmentReference colorAttachmentRef = {};
     colorAttachmentRef.attachment = 0;
@@ -443,13 +1084,26 @@ void Window::createRenderPass()
     subpass.pColorAttachments = &colorAttachmentRef;
     subpass.pResolveAttachments = nullptr;
 
-    VkSubpassDependency subpassDependency = {};
-    subpassDependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-    subpassDependency.dstSubpass = 0;
-    subpassDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    subpassDependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    subpassDependency.srcAccessMask = 0;
-    subpassDependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    std::vector<VkSubpassDependency> subpassDependencies(1);
+    subpassDependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    subpassDependencies[0].dstSubpass = 0;
+    subpassDependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    subpassDependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    subpassDependencies[0].srcAccessMask = 0;
+    subpassDependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+    //offscreen images are copied out by readPixels(), the copy must see the pass's writes
+    if (headless)
+    {
+        VkSubpassDependency readbackDependency = {};
+        readbackDependency.srcSubpass = 0;
+        readbackDependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+        readbackDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        readbackDependency.dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        readbackDependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        readbackDependency.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        subpassDependencies.push_back(readbackDependency);
+    }
 
     std::array<VkAttachmentDescription, 1> attachments = {colorAttachment};
     VkRenderPassCreateInfo renderPassCreateInfo = {};
@@ -458,10 +1112,10 @@ void Window::createRenderPass()
     renderPassCreateInfo.pAttachments = attachments.data();
     renderPassCreateInfo.subpassCount = 1;
     renderPassCreateInfo.pSubpasses = &subpass;
-    renderPassCreateInfo.dependencyCount = 1;
-    renderPassCreateInfo.pDependencies = &subpassDependency;
+    renderPassCreateInfo.dependencyCount = static_cast<uint32_t>(subpassDependencies.size());
+    renderPassCreateInfo.pDependencies = subpassDependencies.data();
 
-    if (device.createRenderPass(&renderPassCreateInfo, nullptr, &pipeline.renderPass) != VK_SUCCESS)
+    if (device->createRenderPass(&renderPassCreateInfo, nullptr, &pipeline.renderPass) != VK_SUCCESS)
     {
         throw std::runtime_error("Error! Failed to create render pass!");
     }
@@ -469,59 +1123,66 @@ void Window::createRenderPass()
 
 void Window::createGraphicsPipeline()
 {
-    auto vertShaderCode = readFile("/build/resources/shaders/vertex.spv");
-    auto fragShaderCode = readFile("/build/resources/shaders/fragment.spv");
+    //modules are kept for the lifetime of the window, rebuilds reuse them
+    if (vertShaderModule == VK_NULL_HANDLE)
+    {
+        vertShaderModule = acquireShaderModule(VERTEX_SHADER_PATH, vertShaderAsset);
+    }
+    if (fragShaderModule == VK_NULL_HANDLE)
+    {
+        fragShaderModule = acquireShaderModule(FRAGMENT_SHADER_PATH, fragShaderAsset);
+    }
 
-    VkShaderModule vertShaderModule = createShaderModule(vertShaderCode);
-    VkShaderModule fragShaderModule = createShaderModule(fragShaderCode);
+    std::vector<ShaderReflection> stageReflections = {
+        device->getShaderLibrary()->getReflection(vertShaderModule),
+        device->getShaderLibrary()->getReflection(fragShaderModule)};
 
     VkPipelineShaderStageCreateInfo vertShaderStageCreateInfo = {};
     vertShaderStageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    vertShaderStageCreateInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+    vertShaderStageCreateInfo.stage = stageReflections[0].stage;
     vertShaderStageCreateInfo.module = vertShaderModule;
-    vertShaderStageCreateInfo.pName = "main";
+    vertShaderStageCreateInfo.pName = stageReflections[0].entryPoint.c_str();
 
     VkPipelineShaderStageCreateInfo fragShaderStageCreateInfo = {};
     fragShaderStageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    fragShaderStageCreateInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    fragShaderStageCreateInfo.stage = stageReflections[1].stage;
     fragShaderStageCreateInfo.module = fragShaderModule;
-    fragShaderStageCreateInfo.pName = "main";
+    fragShaderStageCreateInfo.pName = stageReflections[1].entryPoint.c_str();
+
+    if (vertShaderStageCreateInfo.stage != VK_SHADER_STAGE_VERTEX_BIT || fragShaderStageCreateInfo.stage != VK_SHADER_STAGE_FRAGMENT_BIT)
+    {
+        throw std::runtime_error("Error! Window shaders are not a vertex and a fragment shader!");
+    }
 
     VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageCreateInfo, fragShaderStageCreateInfo};
 
-    auto bindingDescription = Vertex::getBindingDescription();
-    auto attributeDescriptions = Vertex::getAttributeDescriptions();
+    const VertexLayout<2, 4>& vertexLayout = VERTEX_LAYOUTS[vertexFormat];
+
+    //the static_asserts above check the declared inputs, this checks the shader actually loaded
+    if (!matchesShaderInputs(vertexLayout, stageReflections[0].inputs))
+    {
+        throw std::runtime_error("Error! Vertex layout does not match the inputs of " + std::string(VERTEX_SHADER_PATH) + "!");
+    }
 
     VkPipelineVertexInputStateCreateInfo vertexInputStateCreateInfo = {};
     vertexInputStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertexInputStateCreateInfo.vertexBindingDescriptionCount = 1;
-    vertexInputStateCreateInfo.pVertexBindingDescriptions = &bindingDescription;
-    vertexInputStateCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-    vertexInputStateCreateInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+    vertexInputStateCreateInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(vertexLayout.bindings.size());
+    vertexInputStateCreateInfo.pVertexBindingDescriptions = vertexLayout.bindings.data();
+    vertexInputStateCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertexLayout.attributes.size());
+    vertexInputStateCreateInfo.pVertexAttributeDescriptions = vertexLayout.attributes.data();
 
     VkPipelineInputAssemblyStateCreateInfo inputAssemblyStateCreateInfo = {};
     inputAssemblyStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    inputAssemblyStateCreateInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    inputAssemblyStateCreateInfo.topology = topology;
     inputAssemblyStateCreateInfo.primitiveRestartEnable = VK_FALSE;
 
-    VkViewport viewport = {};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = (float) swapchain.extent.width;
-    viewport.height = (float) swapchain.extent.height;
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-
-    VkRect2D scissor = {};
-    scissor.offset = {0, 0};
-    scissor.extent = swapchain.extent;
-
+    //viewport and scissor are set at record time so the pipeline outlives extent changes
     VkPipelineViewportStateCreateInfo viewportStateCreateInfo = {};
     viewportStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
     viewportStateCreateInfo.viewportCount = 1;
-    viewportStateCreateInfo.pViewports = &viewport;
+    viewportStateCreateInfo.pViewports = nullptr;
     viewportStateCreateInfo.scissorCount = 1;
-    viewportStateCreateInfo.pScissors = &scissor;
+    viewportStateCreateInfo.pScissors = nullptr;
 
     VkPipelineRasterizationStateCreateInfo rasterizationStateCreateInfo = {};
     rasterizationStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
@@ -529,8 +1190,8 @@ void Window::createGraphicsPipeline()
     rasterizationStateCreateInfo.rasterizerDiscardEnable = VK_FALSE;
     rasterizationStateCreateInfo.polygonMode = VK_POLYGON_MODE_FILL;
     rasterizationStateCreateInfo.lineWidth = 1.0f;
-    rasterizationStateCreateInfo.cullMode = VK_CULL_MODE_BACK_BIT;
-    rasterizationStateCreateInfo.frontFace = VK_FRONT_FACE_CLOCKWISE;
+    rasterizationStateCreateInfo.cullMode = cullMode;
+    rasterizationStateCreateInfo.frontFace = frontFace;
     rasterizationStateCreateInfo.depthBiasEnable = VK_FALSE;
     rasterizationStateCreateInfo.depthBiasConstantFactor = 0.0f;
     rasterizationStateCreateInfo.depthBiasClamp = 0.0f;
@@ -578,16 +1239,37 @@ void Window::createGraphicsPipeline()
     depthStencilStageCreateInfo.front = {};
     depthStencilStageCreateInfo.back = {};
 
-    VkPipelineLayoutCreateInfo layoutCreateInfo = {};
-    layoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    layoutCreateInfo.setLayoutCount = 0;
-    layoutCreateInfo.pSetLayouts = nullptr;
-    layoutCreateInfo.pushConstantRangeCount = 0;
-    layoutCreateInfo.pPushConstantRanges = nullptr;
+    std::vector<VkDynamicState> dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    if (device->isExtendedDynamicStateSupported())
+    {
+        dynamicStates.push_back(VK_DYNAMIC_STATE_CULL_MODE_EXT);
+        dynamicStates.push_back(VK_DYNAMIC_STATE_FRONT_FACE_EXT);
+        dynamicStates.push_back(VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_EXT);
+    }
+
+    VkPipelineDynamicStateCreateInfo dynamicStateCreateInfo = {};
+    dynamicStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicStateCreateInfo.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+    dynamicStateCreateInfo.pDynamicStates = dynamicStates.data();
+
+    //owned by the device, pipelines with the same interface share it, uniforms are fed from the uniform ring
+    PipelineLayoutInfo layoutInfo = device->getLayoutCache()->getPipelineLayout(stageReflections, true);
+    pipeline.layout = layoutInfo.layout;
+    pipeline.setLayouts = layoutInfo.setLayouts;
+
+    //recordCommandBuffer binds FrameUniforms to set 0, binding 0 and DrawUniforms to binding 1
+    bool uniformsDeclared = !layoutInfo.setBindings.empty() && layoutInfo.setBindings[0].size() == 2;
+    for (uint32_t binding = 0; uniformsDeclared && binding < 2; binding++)
+    {
+        auto it = std::find_if(layoutInfo.setBindings[0].begin(), layoutInfo.setBindings[0].end(), [binding](const VkDescriptorSetLayoutBinding& setBinding) {
+            return setBinding.binding == binding;
+        });
+        uniformsDeclared = it != layoutInfo.setBindings[0].end() && it->descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    }
 
-    if (device.createPipelineLayout(&layoutCreateInfo, nullptr, &pipeline.layout) != VK_SUCCESS)
+    if (!uniformsDeclared)
     {
-        throw std::runtime_error("Error! Failed to create pipeline layout!");
+        throw std::runtime_error("Error! Window shaders do not declare the frame and draw uniform blocks!");
     }
 
     VkGraphicsPipelineCreateInfo pipelineCreateInfo = {};
@@ -601,20 +1283,17 @@ void Window::createGraphicsPipeline()
     pipelineCreateInfo.pMultisampleState = &multisampleStateCreateInfo;
     pipelineCreateInfo.pDepthStencilState = &depthStencilStageCreateInfo;
     pipelineCreateInfo.pColorBlendState = &colorBlendStateCreateInfo;
-    pipelineCreateInfo.pDynamicState = nullptr;
+    pipelineCreateInfo.pDynamicState = &dynamicStateCreateInfo;
     pipelineCreateInfo.layout = pipeline.layout;
     pipelineCreateInfo.renderPass = pipeline.renderPass;
     pipelineCreateInfo.subpass = 0;
     pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
     pipelineCreateInfo.basePipelineIndex = -1;
 
-    if (device.createGraphicsPipelines(VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &pipeline.pipeline) != VK_SUCCESS)
+    if (device->createGraphicsPipelines(device->getPipelineCache(), 1, &pipelineCreateInfo, nullptr, &pipeline.pipeline) != VK_SUCCESS)
     {
         throw std::runtime_error("Error! Failed to create graphics pipeline!");
     }
-
-    device.destroyShaderModule(vertShaderModule, nullptr);
-    device.destroyShaderModule(fragShaderModule, nullptr);
 }
 
 void Window::createFramebuffers()
@@ -632,127 +1311,438 @@ void Window::createFramebuffers()
         framebufferCreateInfo.height = swapchain.extent.height;
         framebufferCreateInfo.layers = 1;
 
-        if (device.createFramebuffer(&framebufferCreateInfo, nullptr, &swapchain.framebuffers[i]) != VK_SUCCESS)
+        if (device->createFramebuffer(&framebufferCreateInfo, nullptr, &swapchain.framebuffers[i]) != VK_SUCCESS)
         {
             throw std::runtime_error("Error! Failed to create framebuffer");
         }
     }
 }
 
-void Window::createVertexBuffer()
+void Window::createGeometryBuffers()
+{
+    //windows drawing the same mesh in the same vertex format share one copy of its buffers
+    std::string geometryKey = (meshPath.empty() ? std::string("quad") : meshPath) + ":" + std::to_string(static_cast<uint32_t>(vertexFormat));
+
+    GeometryBuffers geometry = device->getGeometryCache()->acquire(geometryKey, [this]() {
+        return uploadGeometry();
+    });
+
+    //the contents are staged, or another window uploaded the mesh already
+    if (meshAsset.isValid())
+    {
+        meshAsset.cancel();
+        meshAsset = AssetHandle<std::shared_ptr<MeshFile>>();
+    }
+
+    vertexBuffer = geometry.vertexBuffer;
+    indexBuffer = geometry.indexBuffer;
+    geometryUpload = geometry.upload;
+}
+
+GeometryBuffers Window::uploadGeometry()
+{
+    GeometryBuffers geometry = {};
+
+    if (!meshPath.empty())
+    {
+        //blocks only if the load started at launch has not finished yet
+        MeshFile& meshFile = *meshAsset.get();
+
+        if (meshFile.getVertexFormat() != vertexFormat || meshFile.getHeader().indexCount != indexCount || meshFile.getIndexType() != indexType)
+        {
+            throw std::runtime_error("Error! Mesh file changed since it was set!");
+        }
+
+        device->createBuffer(meshFile.getVertexDataSize(), VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, geometry.vertexBuffer, geometry.vertexBufferAllocation);
+        device->createBuffer(meshFile.getIndexDataSize(), VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, geometry.indexBuffer, geometry.indexBufferAllocation);
+
+        TransferBatch batch;
+        batch.setAsync(true);
+        device->stageBuffer(batch, geometry.vertexBuffer, 0, meshFile.getVertexData(), meshFile.getVertexDataSize());
+        device->stageBuffer(batch, geometry.indexBuffer, 0, meshFile.getIndexData(), meshFile.getIndexDataSize());
+
+        geometry.upload = device->submitTransfers(batch);
+        return geometry;
+    }
+
+    std::vector<uint8_t> packedVertices = packVertices(vertices, vertexFormat);
+
+    VkDeviceSize vertexBufferSize = packedVertices.size();
+    VkDeviceSize indexBufferSize = sizeof(indices[0]) * indices.size();
+
+    device->createBuffer(vertexBufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, geometry.vertexBuffer, geometry.vertexBufferAllocation);
+    device->createBuffer(indexBufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, geometry.indexBuffer, geometry.indexBufferAllocation);
+
+    //both uploads go out in one command buffer on the transfer queue
+    TransferBatch batch;
+    batch.setAsync(true);
+    device->stageBuffer(batch, geometry.vertexBuffer, 0, packedVertices.data(), vertexBufferSize);
+    device->stageBuffer(batch, geometry.indexBuffer, 0, indices.data(), indexBufferSize);
+
+    geometry.upload = device->submitTransfers(batch);
+    return geometry;
+}
+
+void Window::createFrameContexts()
 {
-    VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
+    Queue queue = device->getGraphicsQueues()[0];
 
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
+    frameContexts.resize(framesInFlight);
+    for (auto& frameContext : frameContexts)
+    {
+        frameContext.create(*device, queue.family.queueFamilyIndex, threadPool->getThreadCount() + 1);
+    }
+
+    //instance buffers are allocated on first use and grown as needed
+    InstanceBuffer emptyBuffer = {};
+    instanceBuffers.assign(framesInFlight, emptyBuffer);
+
+    //culling command buffers are recorded by the submitting thread only
+    if (!device->getComputeQueues().empty())
+    {
+        Queue computeQueue = device->getComputeQueues()[0];
+
+        computeContexts.resize(framesInFlight);
+        for (auto& computeContext : computeContexts)
+        {
+            computeContext.create(*device, computeQueue.family.queueFamilyIndex, 1);
+        }
+    }
+
+    drawLists.resize(framesInFlight);
+    for (auto& drawList : drawLists)
+    {
+        drawList.create(*device, static_cast<uint32_t>(instances.size()));
+    }
+
+    uniformRing.create(*device, framesInFlight, UNIFORM_RING_FRAME_SIZE);
+}
+
+void Window::updateInstanceBuffer()
+{
+    InstanceBuffer& instanceBuffer = instanceBuffers[currentFrame];
 
-    device.createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+    VkDeviceSize size = sizeof(InstanceData) * instances.size();
+    if (size == 0)
+    {
+        return;
+    }
 
-    void* data;
-    device.mapMemory(stagingBufferMemory, 0, bufferSize, 0, &data);
-    memcpy(data, vertices.data(), (size_t) bufferSize);
-    device.unmapMemory(stagingBufferMemory);
+    //the fence of this frame was waited on, nothing on the GPU reads the buffer anymore
+    if (size > instanceBuffer.capacity)
+    {
+        if (instanceBuffer.buffer != VK_NULL_HANDLE)
+        {
+            device->destroyBuffer(instanceBuffer.buffer, instanceBuffer.allocation);
+        }
 
-    Queue queue = device.getGraphicsQueues()[0];
-    VkCommandPool commandPool = device.getCommandPool(queue);
+        instanceBuffer.capacity = std::max(size, instanceBuffer.capacity * 2);
+        device->createSharedBuffer(instanceBuffer.capacity, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, instanceBuffer.buffer, instanceBuffer.allocation);
+    }
 
-    device.createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBuffer, vertexBufferMemory);
-    device.copyBuffer(stagingBuffer, vertexBuffer, bufferSize, commandPool, queue.queue);
+    memcpy(instanceBuffer.allocation.pMapped, instances.data(), (size_t) size);
+}
 
-    device.destroyBuffer(stagingBuffer, nullptr);
-    device.freeMemory(stagingBufferMemory, nullptr);
+bool Window::isGpuCullingActive()
+{
+    return gpuCulling && drawMode == DRAW_MODE_INDIRECT && !instances.empty()
+        && device->isDrawIndirectFirstInstanceSupported() && !device->getComputeQueues().empty();
 }
 
-void Window::createIndexBuffer()
+void Window::submitCulling()
 {
-    VkDeviceSize bufferSize = sizeof(indices[0]) * indices.size();
+    if (!cullPassCreated)
+    {
+        cullShaderModule = acquireShaderModule(CULL_SHADER_PATH, cullShaderAsset);
+        cullPass.create(*device, MAX_FRAMES_IN_FLIGHT, cullShaderModule);
+        cullPassCreated = true;
+    }
+
+    Queue computeQueue = device->getComputeQueues()[0];
+
+    FrameContext& computeContext = computeContexts[currentFrame];
+    computeContext.reset(*device);
+
+    VkCommandBuffer commandBuffer = computeContext.getPrimaryBuffer(*device, 0);
+
+    VkCommandBufferBeginInfo commandBufferBeginInfo = {};
+    commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    if (vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Error! Failed to begin cull command buffer!");
+    }
 
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
+    uint32_t instanceCount = static_cast<uint32_t>(instances.size());
 
-    device.createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+    //the GPU writes every draw, the CPU only makes room for them
+    DrawList& drawList = drawLists[currentFrame];
+    drawList.reserve(*device, instanceCount);
+
+    CullParams params = {};
+    for (size_t i = 0; i < cullPlanes.size(); i++)
+    {
+        params.planes[i] = cullPlanes[i];
+    }
+    params.viewTransform = frameUniforms.viewTransform;
+    params.objectCount = instanceCount;
+    params.indexCount = indexCount;
+    params.boundingRadius = meshRadius;
+    params.compact = device->isDrawIndirectCountSupported() ? 1 : 0;
 
-    void* data;
-    device.mapMemory(stagingBufferMemory, 0, bufferSize, 0, &data);
-    memcpy(data, indices.data(), (size_t) bufferSize);
-    device.unmapMemory(stagingBufferMemory);
+    VkBuffer instanceBuffer = instanceBuffers[currentFrame].buffer;
+    cullPass.record(*device, commandBuffer, static_cast<uint32_t>(currentFrame), instanceBuffer, drawList, params);
 
-    Queue queue = device.getGraphicsQueues()[0];
-    VkCommandPool commandPool = device.getCommandPool(queue);
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Error! Failed to end cull command buffer!");
+    }
 
-    device.createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBuffer, indexBufferMemory);
-    device.copyBuffer(stagingBuffer, indexBuffer, bufferSize, commandPool, queue.queue);
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &cullFinishedSemaphores[currentFrame];
 
-    device.destroyBuffer(stagingBuffer, nullptr);
-    device.freeMemory(stagingBufferMemory, nullptr);
+    //completion is covered by the graphics fence, which waits on the semaphore
+    if (device->queueSubmit(computeQueue.queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Error! Failed to submit to compute queue!");
+    }
 }
 
-void Window::createCommandBuffers()
+VkCommandBuffer Window::recordCommandBuffer(uint32_t imageIndex, bool culling)
 {
-    Queue queue = device.getGraphicsQueues()[0];
-    VkCommandPool commandPool = device.getCommandPool(queue);
+    FrameContext& frameContext = frameContexts[currentFrame];
+    uint32_t slot = static_cast<uint32_t>(currentFrame);
+
+    VkCommandBuffer commandBuffer = frameContext.getPrimaryBuffer(*device, 0);
+
+    VkCommandBufferBeginInfo commandBufferBeginInfo = {};
+    commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    commandBufferBeginInfo.pInheritanceInfo = nullptr;
+
+    if (vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Error! Failed to begin command buffer!");
+    }
+
+    profiler->reset(commandBuffer, slot);
+
+    //the render pass is all the frame's command buffer records, a separate frame scope would time the same work
+    uint32_t passScope = profiler->beginScope(commandBuffer, slot, "main pass");
+
+    VkRenderPassBeginInfo renderPassBeginInfo = {};
+    renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassBeginInfo.renderPass = pipeline.renderPass;
+    renderPassBeginInfo.framebuffer = swapchain.framebuffers[imageIndex];
+    renderPassBeginInfo.renderArea.offset = {0, 0};
+    renderPassBeginInfo.renderArea.extent = swapchain.extent;
+
+    VkClearValue clearColor = {0.0f, 0.0f, 0.0f, 1.0f};
+    renderPassBeginInfo.clearValueCount = 1;
+    renderPassBeginInfo.pClearValues = &clearColor;
+
+    vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+    VkCommandBufferInheritanceInfo inheritanceInfo = {};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.renderPass = pipeline.renderPass;
+    inheritanceInfo.subpass = 0;
+    inheritanceInfo.framebuffer = swapchain.framebuffers[imageIndex];
+
+    uint32_t instanceCount = static_cast<uint32_t>(instances.size());
+    DrawMode frameDrawMode = drawMode;
+    if (frameDrawMode == DRAW_MODE_INDIRECT && !device->isDrawIndirectFirstInstanceSupported())
+    {
+        frameDrawMode = DRAW_MODE_INSTANCED;
+    }
+
+    //split the instances evenly across workers, each records its share into its own secondary buffer
+    uint32_t taskCount = std::min(threadPool->getThreadCount(), instanceCount);
+
+    //indirect draws are written to the frame's draw list and go out in a single call
+    DrawList& drawList = drawLists[currentFrame];
+    if (frameDrawMode == DRAW_MODE_INDIRECT)
+    {
+        //with GPU culling the list was already filled on the compute queue
+        if (!culling)
+        {
+            drawList.clear();
+            for (uint32_t instance = 0; instance < instanceCount; instance++)
+            {
+                drawList.addDraw(indexCount, 1, 0, 0, instance);
+            }
+            drawList.upload(*device);
+        }
+
+        taskCount = std::min(taskCount, 1u);
+    }
+
+    std::vector<VkCommandBuffer> secondaryBuffers(taskCount);
+
+    VkBuffer instanceBuffer = instanceBuffers[currentFrame].buffer;
+
+    VkViewport viewport = {};
+    viewport.x = viewportRect[0] * swapchain.extent.width;
+    viewport.y = viewportRect[1] * swapchain.extent.height;
+    viewport.width = viewportRect[2] * swapchain.extent.width;
+    viewport.height = viewportRect[3] * swapchain.extent.height;
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+
+    VkRect2D scissor = {};
+    scissor.offset = {static_cast<int32_t>(viewport.x), static_cast<int32_t>(viewport.y)};
+    scissor.extent = {static_cast<uint32_t>(viewport.width), static_cast<uint32_t>(viewport.height)};
 
-    commandBuffers.resize(swapchain.framebuffers.size());
+    bool extendedDynamicState = device->isExtendedDynamicStateSupported();
 
-    VkCommandBufferAllocateInfo allocInfo = {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.commandPool = commandPool;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandBufferCount = (uint32_t) commandBuffers.size();
+    //the set only points at the ring, the frame's and draw's data are selected by the dynamic offsets
+    uint32_t frameUniformOffset = uniformRing.push(frameUniforms);
+    VkDescriptorSet frameSet = frameContext.allocateDescriptorSet(*device, 0, pipeline.setLayouts[0]);
 
-    if (device.allocateCommandBuffers(&allocInfo, commandBuffers.data()) != VK_SUCCESS)
+    //instanced and indirect draws share one block telling the shader to read the instance stream
+    uint32_t instancedDrawOffset = 0;
+    std::vector<UniformAllocation> drawUniforms(taskCount);
+    if (frameDrawMode == DRAW_MODE_DIRECT)
+    {
+        //one slice per worker, allocated here since the ring is not thread safe
+        for (uint32_t task = 0; task < taskCount; task++)
+        {
+            uint32_t drawCount = instanceCount * (task + 1) / taskCount - instanceCount * task / taskCount;
+            drawUniforms[task] = uniformRing.allocateArray(sizeof(DrawUniforms), drawCount);
+        }
+    }
+    else
     {
-        throw std::runtime_error("Error! Failed to allocate command buffers!");
+        DrawUniforms instancedDraw = {};
+        instancedDraw.instanced = 1;
+        instancedDrawOffset = uniformRing.push(instancedDraw);
     }
 
-    for (size_t i = 0; i < commandBuffers.size(); i++)
+    VkDescriptorBufferInfo uniformBufferInfos[2] = {};
+    uniformBufferInfos[0].buffer = uniformRing.getBuffer();
+    uniformBufferInfos[0].offset = 0;
+    uniformBufferInfos[0].range = sizeof(FrameUniforms);
+    uniformBufferInfos[1].buffer = uniformRing.getBuffer();
+    uniformBufferInfos[1].offset = 0;
+    uniformBufferInfos[1].range = sizeof(DrawUniforms);
+
+    VkWriteDescriptorSet frameSetWrite = {};
+    frameSetWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    frameSetWrite.dstSet = frameSet;
+    frameSetWrite.dstBinding = 0;
+    frameSetWrite.descriptorCount = 2;
+    frameSetWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    frameSetWrite.pBufferInfo = uniformBufferInfos;
+
+    device->updateDescriptorSets(1, &frameSetWrite);
+
+    threadPool->run(taskCount, [&](uint32_t task, uint32_t worker)
     {
-        VkCommandBufferBeginInfo commandBufferBeginInfo = {};
-        commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        commandBufferBeginInfo.flags = 0;
-        commandBufferBeginInfo.pInheritanceInfo = nullptr;
+        VkCommandBuffer secondaryBuffer = frameContext.getSecondaryBuffer(*device, worker + 1);
+
+        VkCommandBufferBeginInfo secondaryBeginInfo = {};
+        secondaryBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        secondaryBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        secondaryBeginInfo.pInheritanceInfo = &inheritanceInfo;
+
+        if (vkBeginCommandBuffer(secondaryBuffer, &secondaryBeginInfo) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Error! Failed to begin secondary command buffer!");
+        }
+
+        vkCmdBindPipeline(secondaryBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline);
+
+        //dynamic offsets follow binding order, frame block first
+        uint32_t dynamicOffsets[] = {frameUniformOffset, instancedDrawOffset};
+        if (frameDrawMode != DRAW_MODE_DIRECT)
+        {
+            vkCmdBindDescriptorSets(secondaryBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.layout, 0, 1, &frameSet, 2, dynamicOffsets);
+        }
+
+        //dynamic state is not inherited, every secondary buffer sets its own
+        vkCmdSetViewport(secondaryBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(secondaryBuffer, 0, 1, &scissor);
 
-        if (vkBeginCommandBuffer(commandBuffers[i], &commandBufferBeginInfo) != VK_SUCCESS)
+        if (extendedDynamicState)
         {
-            throw std::runtime_error("Error! Failed to begin command buffers!");
+            device->cmdSetCullMode(secondaryBuffer, cullMode);
+            device->cmdSetFrontFace(secondaryBuffer, frontFace);
+            device->cmdSetPrimitiveTopology(secondaryBuffer, topology);
         }
 
-        VkRenderPassBeginInfo renderPassBeginInfo = {};
-        renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        renderPassBeginInfo.renderPass = pipeline.renderPass;
-        renderPassBeginInfo.framebuffer = swapchain.framebuffers[i];
-        renderPassBeginInfo.renderArea.offset = {0, 0};
-        renderPassBeginInfo.renderArea.extent = swapchain.extent;
+        VkBuffer vertexBuffers[] = {vertexBuffer, instanceBuffer};
+        VkDeviceSize offsets[] = {0, 0};
+        vkCmdBindVertexBuffers(secondaryBuffer, 0, 2, vertexBuffers, offsets);
 
-        VkClearValue clearColor = {0.0f, 0.0f, 0.0f, 1.0f};
-        renderPassBeginInfo.clearValueCount = 1;
-        renderPassBeginInfo.pClearValues = &clearColor;
+        vkCmdBindIndexBuffer(secondaryBuffer, indexBuffer, 0, indexType);
 
-        vkCmdBeginRenderPass(commandBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-        vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline);
+        uint32_t firstInstance = instanceCount * task / taskCount;
+        uint32_t lastInstance = instanceCount * (task + 1) / taskCount;
+
+        switch (frameDrawMode)
+        {
+            case DRAW_MODE_DIRECT:
+                for (uint32_t instance = firstInstance; instance < lastInstance; instance++)
+                {
+                    uint32_t draw = instance - firstInstance;
 
-        VkBuffer vertexBuffers[] = {vertexBuffer};
-        VkDeviceSize offsets[] = {0};
-        vkCmdBindVertexBuffers(commandBuffers[i], 0, 1, vertexBuffers, offsets);
+                    DrawUniforms* pDraw = reinterpret_cast<DrawUniforms*>(static_cast<char*>(drawUniforms[task].pMapped) + draw * drawUniforms[task].stride);
+                    pDraw->transform = instances[instance].transform;
+                    pDraw->color = glm::vec4(instances[instance].color, 1.0f);
+                    pDraw->instanced = 0;
 
-        vkCmdBindIndexBuffer(commandBuffers[i], indexBuffer, 0, VK_INDEX_TYPE_UINT16);
+                    //rebinding the same set with new offsets is the cheapest way to switch per-draw data
+                    dynamicOffsets[1] = drawUniforms[task].offset + draw * drawUniforms[task].stride;
+                    vkCmdBindDescriptorSets(secondaryBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.layout, 0, 1, &frameSet, 2, dynamicOffsets);
 
-        vkCmdDrawIndexed(commandBuffers[i], static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
-        vkCmdEndRenderPass(commandBuffers[i]);
+                    vkCmdDrawIndexed(secondaryBuffer, indexCount, 1, 0, 0, instance);
+                }
+                break;
+            case DRAW_MODE_INSTANCED:
+                vkCmdDrawIndexed(secondaryBuffer, indexCount, lastInstance - firstInstance, 0, 0, firstInstance);
+                break;
+            case DRAW_MODE_INDIRECT:
+                drawList.record(*device, secondaryBuffer);
+                break;
+        }
 
-        if (vkEndCommandBuffer(commandBuffers[i]) != VK_SUCCESS)
+        if (vkEndCommandBuffer(secondaryBuffer) != VK_SUCCESS)
         {
-            throw std::runtime_error("Error! Failed to end command buffer!");
+            throw std::runtime_error("Error! Failed to end secondary command buffer!");
         }
+
+        secondaryBuffers[task] = secondaryBuffer;
+    });
+
+    if (!secondaryBuffers.empty())
+    {
+        vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(secondaryBuffers.size()), secondaryBuffers.data());
+    }
+
+    vkCmdEndRenderPass(commandBuffer);
+
+    profiler->endScope(commandBuffer, slot, passScope);
+
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Error! Failed to end command buffer!");
     }
+
+    return commandBuffer;
 }
 
 void Window::createSyncObjects()
 {
-    imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-    imagesInFlight.resize(swapchain.images.size(), VK_NULL_HANDLE);
+    imageAvailableSemaphores.resize(framesInFlight);
+    renderFinishedSemaphores.resize(framesInFlight);
+    inFlightFences.resize(framesInFlight);
+    cullFinishedSemaphores.resize(framesInFlight);
+    imagesInFlight.assign(swapchain.images.size(), VK_NULL_HANDLE);
 
     VkSemaphoreCreateInfo semaphoreCreateInfo = {};
     semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -761,59 +1751,203 @@ void Window::createSyncObjects()
     fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
     fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    for (size_t i = 0; i < framesInFlight; i++)
     {
-        if (device.createSemaphore(&semaphoreCreateInfo, nullptr, &imageAvailableSemaphores[i]) != VK_SUCCESS
-         || device.createSemaphore(&semaphoreCreateInfo, nullptr, &renderFinishedSemaphores[i]) != VK_SUCCESS
-         || device.createFence(&fenceCreateInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS)
+        if (device->createSemaphore(&semaphoreCreateInfo, nullptr, &imageAvailableSemaphores[i]) != VK_SUCCESS
+         || device->createSemaphore(&semaphoreCreateInfo, nullptr, &renderFinishedSemaphores[i]) != VK_SUCCESS
+         || device->createSemaphore(&semaphoreCreateInfo, nullptr, &cullFinishedSemaphores[i]) != VK_SUCCESS
+         || device->createFence(&fenceCreateInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS)
         {
             throw std::runtime_error("Error! Failed to create sync objects!");
         }
     }
 }
 
-void Window::destroySwapchain()
+void Window::destroySyncObjects()
+{
+    for (size_t i = 0; i < inFlightFences.size(); i++)
+    {
+        device->destroySemaphore(imageAvailableSemaphores[i], nullptr);
+        device->destroySemaphore(renderFinishedSemaphores[i], nullptr);
+        device->destroySemaphore(cullFinishedSemaphores[i], nullptr);
+        device->destroyFence(inFlightFences[i], nullptr);
+    }
+
+    imageAvailableSemaphores.clear();
+    renderFinishedSemaphores.clear();
+    cullFinishedSemaphores.clear();
+    inFlightFences.clear();
+    imagesInFlight.clear();
+}
+
+void Window::destroyFrameContexts()
+{
+    for (auto& frameContext : frameContexts)
+    {
+        frameContext.destroy(*device);
+    }
+
+    frameContexts.clear();
+
+    uniformRing.destroy(*device);
+
+    for (auto& computeContext : computeContexts)
+    {
+        computeContext.destroy(*device);
+    }
+
+    computeContexts.clear();
+
+    for (auto& instanceBuffer : instanceBuffers)
+    {
+        if (instanceBuffer.buffer != VK_NULL_HANDLE)
+        {
+            device->destroyBuffer(instanceBuffer.buffer, instanceBuffer.allocation);
+        }
+    }
+
+    instanceBuffers.clear();
+
+    for (auto& drawList : drawLists)
+    {
+        drawList.destroy(*device);
+    }
+
+    drawLists.clear();
+}
+
+void Window::recreateSwapchain()
 {
-    for (auto framebuffer : swapchain.framebuffers)
+    //only frames still in flight can reference the old images and framebuffers
+    if (!inFlightFences.empty())
     {
-        device.destroyFramebuffer(framebuffer, nullptr);
+        device->waitForFences(static_cast<uint32_t>(inFlightFences.size()), inFlightFences.data(), VK_TRUE, UINT64_MAX);
     }
 
-    Queue commandBufferQueue = device.getGraphicsQueues()[0];
-    VkCommandPool commandPool = device.getCommandPool(commandBufferQueue);
+    Swapchain oldSwapchain = swapchain;
+    std::vector<Allocation> oldAllocations;
+    oldAllocations.swap(offscreenAllocations);
+
+    swapchain.images.clear();
+    swapchain.imageViews.clear();
+    swapchain.framebuffers.clear();
+
+    //the old swapchain is handed over so the presentation engine can reuse its resources
+    createSwapchain(oldSwapchain.swapchain);
+
+    //fences do not cover presents, the old images and the semaphores their presents wait on are kept until
+    //every frame slot has been waited on again. Frame 'frameCount + framesInFlight' is the first to wait on a
+    //fence signalled after this point, the last slot follows framesInFlight - 1 frames later
+    RetiredSwapchain retired = {};
+    retired.swapchain = oldSwapchain;
+    retired.allocations.swap(oldAllocations);
+    retired.renderFinishedSemaphores.swap(renderFinishedSemaphores);
+    retired.destroyFrame = frameCount + 2 * framesInFlight - 1;
+    retiredSwapchains.push_back(retired);
+
+    if (!retired.renderFinishedSemaphores.empty())
+    {
+        VkSemaphoreCreateInfo semaphoreCreateInfo = {};
+        semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+        renderFinishedSemaphores.resize(retired.renderFinishedSemaphores.size());
+        for (auto& semaphore : renderFinishedSemaphores)
+        {
+            if (device->createSemaphore(&semaphoreCreateInfo, nullptr, &semaphore) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Error! Failed to create sync objects!");
+            }
+        }
+    }
 
-    device.freeCommandBuffers(commandPool, (uint32_t) commandBuffers.size(), commandBuffers.data());
+    if (swapchain.format != oldSwapchain.format)
+    {
+        device->destroyPipeline(pipeline.pipeline, nullptr);
+        device->destroyRenderPass(pipeline.renderPass, nullptr);
 
-    device.destroyPipeline(pipeline.pipeline, nullptr);
+        createRenderPass();
+        createGraphicsPipeline();
+    }
 
-    device.destroyPipelineLayout(pipeline.layout, nullptr);
+    createFramebuffers();
 
-    device.destroyRenderPass(pipeline.renderPass, nullptr);
+    imagesInFlight.assign(swapchain.images.size(), VK_NULL_HANDLE);
+}
 
-    for (auto imageView : swapchain.imageViews)
+void Window::destroyRetiredSwapchains(bool idle)
+{
+    for (auto it = retiredSwapchains.begin(); it != retiredSwapchains.end();)
     {
-        device.destroyImageView(imageView, nullptr);
+        if (!idle && frameCount < it->destroyFrame)
+        {
+            ++it;
+            continue;
+        }
+
+        destroySwapchainImages(it->swapchain, it->allocations);
+
+        for (VkSemaphore semaphore : it->renderFinishedSemaphores)
+        {
+            device->destroySemaphore(semaphore, nullptr);
+        }
+
+        it = retiredSwapchains.erase(it);
     }
+}
+
+void Window::destroySwapchain()
+{
+    device->destroyPipeline(pipeline.pipeline, nullptr);
 
-    device.destroySwapchain(swapchain.swapchain, nullptr);
+    device->destroyRenderPass(pipeline.renderPass, nullptr);
+
+    destroySwapchainImages(swapchain, offscreenAllocations);
+
+    swapchain.swapchain = VK_NULL_HANDLE;
 }
 
-VkShaderModule Window::createShaderModule(const std::vector<char>& code)
+void Window::destroySwapchainImages(Swapchain& target, std::vector<Allocation>& allocations)
 {
-    VkShaderModuleCreateInfo moduleCreateInfo = {};
-    moduleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    moduleCreateInfo.codeSize = code.size();
-    moduleCreateInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+    for (auto framebuffer : target.framebuffers)
+    {
+        device->destroyFramebuffer(framebuffer, nullptr);
+    }
 
-    VkShaderModule module;
-    if (device.createShaderModule(&moduleCreateInfo, nullptr, &module) != VK_SUCCESS)
+    for (auto imageView : target.imageViews)
+    {
+        device->destroyImageView(imageView, nullptr);
+    }
+
+    if (headless)
+    {
+        for (size_t i = 0; i < target.images.size(); i++)
+        {
+            device->destroyImage(target.images[i], allocations[i]);
+        }
+        allocations.clear();
+    }
+    else
     {
-        throw std::runtime_error("Error! Failed to create shader module!");
+        device->destroySwapchain(target.swapchain, nullptr);
     }
-    return module;
+
+    target.framebuffers.clear();
+    target.imageViews.clear();
+    target.images.clear();
 }
 
-void createNewDevice(Window& window, Device* device)
+VkShaderModule Window::acquireShaderModule(const std::string& path, AssetHandle<std::vector<char>>& asset)
 {
+    ShaderLibrary* shaderLibrary = device->getShaderLibrary();
+
+    //another window on the device already holds the module or its code, the load started at launch is not needed
+    VkShaderModule module = shaderLibrary->acquire(path);
+    if (module != VK_NULL_HANDLE)
+    {
+        asset.cancel();
+        return module;
+    }
 
+    //blocks only if the load started at launch has not finished yet
+    return shaderLibrary->acquire(asset.get(), path);
 }
\ No newline at end of file
@@ -4,10 +4,31 @@
 layout (location = 0) in vec2 inPosition;
 layout (location = 1) in vec3 inColor;
 
+layout (location = 2) in vec4 inInstanceTransform;
+layout (location = 3) in vec3 inInstanceColor;
+
 layout (location = 0) out vec3 fragColor;
 
+//FrameUniforms in window.hpp, bound with a dynamic offset into the window's uniform ring
+layout (set = 0, binding = 0) uniform FrameUniforms
+{
+    vec4 viewTransform; //xy offset, zw scale applied after the instance transform
+} frame;
+
+//DrawUniforms in window.hpp, rebound with a new dynamic offset before every direct draw
+layout (set = 0, binding = 1) uniform DrawUniforms
+{
+    vec4 transform; //replaces the instance transform unless instanced is set
+    vec4 color;
+    uint instanced;
+} draw;
+
 void main()
 {
-    gl_Position = vec4(inPosition, 0.0, 1.0);
-    fragColor = inColor;
+    vec4 transform = draw.instanced != 0 ? inInstanceTransform : draw.transform;
+    vec3 color = draw.instanced != 0 ? inInstanceColor : draw.color.xyz;
+
+    vec2 position = inPosition * transform.zw + transform.xy;
+    gl_Position = vec4(position * frame.viewTransform.zw + frame.viewTransform.xy, 0.0, 1.0);
+    fragColor = inColor * color;
 }
\ No newline at end of file
@@ -0,0 +1,75 @@
+#include <mesh.hpp>
+#include <meshfile.hpp>
+
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/*! @brief Converts a Wavefront OBJ file into a binary mesh file.
+ *
+ * The mesh is deduplicated and reordered for the vertex cache before it is written.
+ *
+ * Usage: tool_MeshConvert input.obj output.hmesh [float|half|snorm16] [--overdraw]
+ */
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::cout << "Usage: " << argv[0] << " input.obj output.hmesh [float|half|snorm16] [--overdraw]" << std::endl;
+        return 1;
+    }
+
+    VertexFormat format = VERTEX_FORMAT_FLOAT;
+    bool overdraw = false;
+
+    for (int i = 3; i < argc; i++)
+    {
+        if (strcmp(argv[i], "float") == 0)
+        {
+            format = VERTEX_FORMAT_FLOAT;
+        }
+        else if (strcmp(argv[i], "half") == 0)
+        {
+            format = VERTEX_FORMAT_HALF;
+        }
+        else if (strcmp(argv[i], "snorm16") == 0)
+        {
+            format = VERTEX_FORMAT_SNORM16;
+        }
+        else if (strcmp(argv[i], "--overdraw") == 0)
+        {
+            overdraw = true;
+            std::cout << "Warning! --overdraw has no effect on two dimensional meshes" << std::endl;
+        }
+        else
+        {
+            std::cout << "Error! Unknown option: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    try
+    {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        loadObjFile(argv[1], vertices, indices);
+
+        MeshReport report = optimizeMesh(vertices, indices, overdraw);
+
+        writeMeshFile(argv[2], vertices, indices, format);
+
+        std::cout << argv[2] << ": " << report.after.vertexCount << " vertices, " << report.after.triangleCount << " triangles, "
+            << getVertexStride(format) << " bytes/vertex, ACMR " << report.before.acmr << " -> " << report.after.acmr
+            << ", ATVR " << report.before.atvr << " -> " << report.after.atvr << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}